@@ -0,0 +1,211 @@
+#include "channel_mux.h"
+#include "serial_port.h"
+#include "system_time.h"
+#include <stddef.h>
+
+/* ************************************************************************** */
+
+typedef struct {
+    channel_consumer_t consumers[NUMBER_OF_CHANNELS];
+    channel_timeout_t timeoutHandler;
+
+    // inbound
+    channel_t inbound;
+    unsigned tagged : 1; // the host is sending tags, so don't guess
+    unsigned lineStart : 1;
+    unsigned lineEnding : 1; // a JUDI message just ended, eat its CR/LF
+
+    // automatic JUDI detection
+    uint8_t depth;
+    unsigned inString : 1;
+    unsigned escaped : 1;
+    system_time_t lastByteTime;
+
+    // outbound
+    channel_t outbound;
+    uint8_t lastTag; // the channel the host thinks we're printing on
+    unsigned sendTags : 1;
+} channel_mux_t;
+
+static channel_mux_t mux;
+
+// means the host hasn't been told about any channel yet
+#define NO_TAG 0xff
+
+/* ************************************************************************** */
+
+void channel_mux_init(void) {
+    for (uint8_t i = 0; i < NUMBER_OF_CHANNELS; i++) {
+        mux.consumers[i] = NULL;
+    }
+    mux.timeoutHandler = NULL;
+
+    mux.inbound = CHANNEL_SHELL;
+    mux.tagged = false;
+    mux.lineStart = true;
+    mux.lineEnding = false;
+    mux.depth = 0;
+    mux.inString = false;
+    mux.escaped = false;
+
+    mux.outbound = CHANNEL_SHELL;
+    mux.lastTag = NO_TAG;
+    mux.sendTags = false;
+}
+
+void channel_mux_set_consumer(channel_t channel, channel_consumer_t consumer) {
+    mux.consumers[channel] = consumer; //
+}
+
+void channel_mux_set_timeout_handler(channel_timeout_t handler) {
+    mux.timeoutHandler = handler; //
+}
+
+/* -------------------------------------------------------------------------- */
+
+/*  Selecting a channel doesn't send anything by itself. Consumers are
+    selected for every byte they're given, and most of the time they don't
+    print anything, so the tag is only sent once something actually goes out.
+*/
+channel_t channel_mux_select(channel_t channel) {
+    channel_t previous = mux.outbound;
+
+    mux.outbound = channel;
+
+    return previous;
+}
+
+void channel_mux_enable_tags(bool enable) {
+    mux.sendTags = enable;
+
+    // make sure the host is told where we are before the next output
+    mux.lastTag = NO_TAG;
+}
+
+void channel_mux_tag_output(void) {
+    if (mux.sendTags && mux.lastTag != mux.outbound) {
+        // update this first, because putch() calls right back in here
+        mux.lastTag = mux.outbound;
+        putch(CHANNEL_TAG_BASE + mux.outbound);
+    }
+}
+
+/* ************************************************************************** */
+
+// hand a byte to a channel, with outbound switched to match while it runs
+static void deliver(channel_t channel, char currentChar) {
+    if (!mux.consumers[channel]) {
+        return;
+    }
+
+    channel_t previous = channel_mux_select(channel);
+    mux.consumers[channel](currentChar);
+    channel_mux_select(previous);
+}
+
+/*  Track the nesting level of an automatically detected JUDI message, so we
+    know when it's over. Returns true on the closing brace of the object.
+*/
+static bool judi_message_complete(char currentChar) {
+    if (mux.inString) {
+        if (mux.escaped) {
+            mux.escaped = false;
+        } else if (currentChar == '\\') {
+            mux.escaped = true;
+        } else if (currentChar == '"') {
+            mux.inString = false;
+        }
+        return false;
+    }
+
+    switch (currentChar) {
+    case '"':
+        mux.inString = true;
+        break;
+    case '{':
+        mux.depth++;
+        break;
+    case '}':
+        if (--mux.depth == 0) {
+            return true;
+        }
+        break;
+    }
+    return false;
+}
+
+static void start_judi_message(void) {
+    mux.inbound = CHANNEL_JUDI;
+    mux.depth = 0;
+    mux.inString = false;
+    mux.escaped = false;
+}
+
+static void route_automatically(char currentChar) {
+    // the line ending after a message belongs to it, don't show it to the
+    // shell, which would draw an empty prompt
+    if (mux.lineEnding) {
+        mux.lineEnding = (currentChar == '\r');
+        if (currentChar == '\r' || currentChar == '\n') {
+            return;
+        }
+    }
+
+    if (mux.inbound == CHANNEL_SHELL) {
+        if (currentChar == '{' && mux.lineStart) {
+            start_judi_message();
+        } else {
+            mux.lineStart = (currentChar == '\r' || currentChar == '\n');
+            deliver(CHANNEL_SHELL, currentChar);
+            return;
+        }
+    }
+
+    mux.lastByteTime = get_current_time();
+    deliver(CHANNEL_JUDI, currentChar);
+
+    if (judi_message_complete(currentChar)) {
+        mux.inbound = CHANNEL_SHELL;
+        mux.lineStart = true;
+        mux.lineEnding = true;
+    }
+}
+
+void channel_mux_update(char currentChar) {
+    // nothing was received, but everyone still gets a chance to run
+    if (currentChar == 0) {
+        // a message that went quiet was probably a typo, give the shell back
+        if (!mux.tagged && mux.inbound == CHANNEL_JUDI &&
+            time_since(mux.lastByteTime) > CHANNEL_MUX_TIMEOUT) {
+            mux.inbound = CHANNEL_SHELL;
+            mux.lineStart = true;
+
+            // the rest of it isn't coming, so don't let it corrupt the next one
+            if (mux.timeoutHandler) {
+                mux.timeoutHandler();
+            }
+        }
+
+        for (uint8_t i = 0; i < NUMBER_OF_CHANNELS; i++) {
+            deliver(i, 0);
+        }
+        return;
+    }
+
+    // a tag byte switches channels, and means the host is using tags
+    if ((uint8_t)currentChar >= CHANNEL_TAG_BASE &&
+        (uint8_t)currentChar < CHANNEL_TAG_BASE + NUMBER_OF_CHANNELS) {
+        if (!mux.tagged) {
+            mux.tagged = true;
+            channel_mux_enable_tags(true);
+        }
+        mux.inbound = currentChar - CHANNEL_TAG_BASE;
+        return;
+    }
+
+    if (mux.tagged) {
+        deliver(mux.inbound, currentChar);
+    } else {
+        route_automatically(currentChar);
+    }
+}
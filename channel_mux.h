@@ -0,0 +1,107 @@
+#ifndef _CHANNEL_MUX_H_
+#define _CHANNEL_MUX_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* ************************************************************************** */
+/*  Notes on using the channel multiplexer
+
+    When the shell and JUDI share one UART, every received byte has to go to
+    exactly one of them. Feeding both with every byte doesn't work: the shell
+    echoes JSON back out in the middle of JUDI traffic, and JUDI happily
+    collects anything the user types inside braces.
+
+    The multiplexer sits between getch() and the consumers, and decides where
+    each byte goes. It works in one of two modes:
+
+    Automatic (the default)
+        Everything goes to the shell, except that a '{' at the beginning of a
+        line starts a JUDI message. Bytes go to JUDI until the closing brace
+        of that object (braces inside strings don't count), or until nothing
+        has been received for CHANNEL_MUX_TIMEOUT mS. A message that times
+        out is abandoned, and the timeout handler is called so JUDI can throw
+        away what it's collected so far. A person at a terminal
+        never needs to know the multiplexer exists, and a host can send JUDI
+        messages as long as it sends each one on its own line.
+
+    Tagged
+        A host that knows about the multiplexer can prefix data with a tag
+        byte to say which channel it belongs to. The tag stays in effect
+        until the next one. The first tag received switches to tagged mode
+        for good, and also turns on outbound tags.
+
+            0x1C (FS)   shell
+            0x1D (GS)   JUDI
+            0x1E (RS)   logs (outbound only)
+
+    Outbound, there's no way to intercept everything that's printed, so the
+    multiplexer tracks who is printing instead. The outbound channel is
+    switched to match each consumer while it's running, log messages select
+    the log channel while they print, and application code that sends
+    something on its own can call channel_mux_select(). When outbound tags are
+    turned on, serial_port.c sends a tag byte before any output that's on a
+    different channel than the last output. Only the serial port is
+    multiplexed, so nothing sent through usb_port.c is ever tagged.
+
+    Example:
+        void judi_consumer(char currentChar) {
+            judi_serial_update(currentChar); //
+        }
+
+        channel_mux_set_consumer(CHANNEL_SHELL, shell_update);
+        channel_mux_set_consumer(CHANNEL_JUDI, judi_consumer);
+        channel_mux_set_timeout_handler(judi_reset);
+
+        while (1) {
+            channel_mux_update(getch());
+        }
+*/
+
+typedef enum {
+    CHANNEL_SHELL,
+    CHANNEL_JUDI,
+    CHANNEL_LOG,
+    NUMBER_OF_CHANNELS,
+} channel_t;
+
+// the tag byte for each channel is CHANNEL_TAG_BASE + channel
+#define CHANNEL_TAG_BASE 0x1C
+
+// how long an automatically detected JUDI message can go quiet, in mS
+#define CHANNEL_MUX_TIMEOUT 100
+
+// a function that accepts received bytes, 0 means nothing was received
+typedef void (*channel_consumer_t)(char currentChar);
+
+// a function that's called when a JUDI message times out
+typedef void (*channel_timeout_t)(void);
+
+/* ************************************************************************** */
+
+// setup
+extern void channel_mux_init(void);
+
+// give a channel somewhere to send its bytes
+extern void channel_mux_set_consumer(channel_t channel,
+                                     channel_consumer_t consumer);
+
+// called when an automatically detected JUDI message goes quiet
+extern void channel_mux_set_timeout_handler(channel_timeout_t handler);
+
+// call this with every result of getch(), including 0
+extern void channel_mux_update(char currentChar);
+
+/* -------------------------------------------------------------------------- */
+
+// switch the outbound channel, returns the previous one so it can be restored
+extern channel_t channel_mux_select(channel_t channel);
+
+// turn outbound tags on or off, they turn on automatically when a tag arrives
+extern void channel_mux_enable_tags(bool enable);
+
+// send a tag if the outbound channel changed, called by serial_port.c before
+// it sends anything
+extern void channel_mux_tag_output(void);
+
+#endif // _CHANNEL_MUX_H_
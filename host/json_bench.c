@@ -0,0 +1,338 @@
+#define JSMN_STATIC
+#define JSMN_PARENT_LINKS
+#include "os/json/jsmn.h"
+
+#define SKIP_JUDI_ENUMS
+#include "judi.h"
+#undef SKIP_JUDI_ENUMS
+
+#include "os/json/json_print.h"
+#include "os/judi/hash.h"
+#include "os/judi/judi_messages.h"
+#include "os/judi/timestamp.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/* ************************************************************************** */
+/*  JSON pipeline benchmark
+
+    Runs a corpus of representative JUDI traffic through each stage of the
+    JSON pipeline, using the same json/ and judi/ sources that ship on the
+    device, and reports how long each stage takes on the host.
+
+    Incoming messages are read from a corpus file, one message per line. They
+    go through jsmn_parse() and compute_hash() on their own, then through
+    preprocess() as a whole, which is what judi_update() actually calls, and
+    then find_key(). Outgoing node lists from judi_messages.c are printed with
+    json_print() to a printer that only counts the bytes.
+
+    The host is much faster than a PIC18, so the absolute numbers don't mean
+    much. What matters is that they don't get worse. Each stage has a limit
+    per message, and if any stage goes over its limit, or anything in the
+    pipeline touches the heap, the benchmark exits with a non-zero status.
+
+    Run it like this:
+        $ make bench
+        $ ./build/jsonbench [iterations] [corpus file]
+*/
+
+/*  maximum allowed time per message for each stage, in nanoseconds
+
+    These are roughly five times what an ordinary desktop measures at -O2
+    (about 100, 70, 240, 10 and 260 nS), so a slow CI machine still passes,
+    but an accidental O(n^2) doesn't. Override them with -D if your machine
+    needs something different.
+*/
+#ifndef JSONBENCH_PARSE_LIMIT_NS
+#define JSONBENCH_PARSE_LIMIT_NS 500
+#endif
+#ifndef JSONBENCH_HASH_LIMIT_NS
+#define JSONBENCH_HASH_LIMIT_NS 350
+#endif
+#ifndef JSONBENCH_PREPROCESS_LIMIT_NS
+#define JSONBENCH_PREPROCESS_LIMIT_NS 1200
+#endif
+#ifndef JSONBENCH_FIND_KEY_LIMIT_NS
+#define JSONBENCH_FIND_KEY_LIMIT_NS 50
+#endif
+#ifndef JSONBENCH_PRINT_LIMIT_NS
+#define JSONBENCH_PRINT_LIMIT_NS 1300
+#endif
+
+// the device has no heap, so nothing in the pipeline should allocate
+#ifndef JSONBENCH_ALLOCATION_LIMIT
+#define JSONBENCH_ALLOCATION_LIMIT 0
+#endif
+
+#define DEFAULT_ITERATIONS 20000
+#define DEFAULT_CORPUS "request_corpus.txt"
+
+/* ************************************************************************** */
+// allocation counting, see -Wl,--wrap in the Makefile
+
+static uint32_t allocations;
+
+extern void *__real_malloc(size_t size);
+extern void *__real_calloc(size_t count, size_t size);
+extern void *__real_realloc(void *pointer, size_t size);
+
+void *__wrap_malloc(size_t size) {
+    allocations++;
+    return __real_malloc(size);
+}
+
+void *__wrap_calloc(size_t count, size_t size) {
+    allocations++;
+    return __real_calloc(count, size);
+}
+
+void *__wrap_realloc(void *pointer, size_t size) {
+    allocations++;
+    return __real_realloc(pointer, size);
+}
+
+/* ************************************************************************** */
+// corpus
+
+#define MAX_REQUESTS 32
+
+static char requestCorpus[MAX_REQUESTS][JSON_BUFFER_SIZE];
+static uint8_t numRequests;
+
+// read one message per line, skipping blank lines
+static bool load_corpus(const char *path) {
+    FILE *file = fopen(path, "r");
+    if (!file) {
+        printf("can't open corpus file: %s\n", path);
+        return false;
+    }
+
+    char line[JSON_BUFFER_SIZE + 2];
+    while (numRequests < MAX_REQUESTS && fgets(line, sizeof(line), file)) {
+        line[strcspn(line, "\r\n")] = '\0';
+        if (line[0] == '\0') {
+            continue;
+        }
+        strcpy(requestCorpus[numRequests++], line);
+    }
+
+    fclose(file);
+
+    if (numRequests == 0) {
+        printf("corpus file is empty: %s\n", path);
+        return false;
+    }
+    return true;
+}
+
+static uint16_t statusTemperature = 21;
+static uint16_t statusSpeed = 1200;
+
+// a typical periodic status update
+static const json_node_t statusUpdate[] = {
+    {nNodeList, (void *)updatePreamble},  //
+    {TIMESTAMP_NODE},                     //
+    {nKey, "mode"},                       //
+    {nString, "auto"},                    //
+    {nKey, "temperature"},                //
+    {nU16, (void *)&statusTemperature},   //
+    {nKey, "speed"},                      //
+    {nU16, (void *)&statusSpeed},         //
+    {nControl, "\e"},                     //
+};
+
+// outgoing messages
+static const json_node_t *const responseCorpus[] = {
+    responseOk,
+    responseError,
+    deviceInfo,
+    statusUpdate,
+};
+#define NUM_RESPONSES (sizeof(responseCorpus) / sizeof(responseCorpus[0]))
+
+/* ************************************************************************** */
+
+static uint64_t now_ns(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (uint64_t)now.tv_sec * 1000000000 + now.tv_nsec;
+}
+
+static uint64_t printedBytes;
+
+static void counting_printer(const char *string) {
+    printedBytes += strlen(string); //
+}
+
+/* -------------------------------------------------------------------------- */
+
+// json_buffer_t is too big to put on the stack
+static json_buffer_t buffers[MAX_REQUESTS];
+
+// load every request into its buffer, the same way judi_update() would
+static void load_requests(void) {
+    for (uint8_t i = 0; i < numRequests; i++) {
+        json_buffer_t *buf = &buffers[i];
+
+        memset(buf, 0, sizeof(json_buffer_t));
+        strcpy(buf->data, requestCorpus[i]);
+        buf->length = strlen(buf->data);
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+
+typedef struct {
+    const char *name;
+    uint64_t time;
+    uint64_t messages;
+    uint64_t bytes;
+    uint32_t allocations;
+    uint32_t limit;
+} stage_t;
+
+enum { PARSE, HASH, PREPROCESS, FIND_KEY, PRINT, NUM_STAGES };
+
+static stage_t stages[NUM_STAGES] = {
+    [PARSE] = {"parse", .limit = JSONBENCH_PARSE_LIMIT_NS},
+    [HASH] = {"hash", .limit = JSONBENCH_HASH_LIMIT_NS},
+    [PREPROCESS] = {"preprocess", .limit = JSONBENCH_PREPROCESS_LIMIT_NS},
+    [FIND_KEY] = {"find_key", .limit = JSONBENCH_FIND_KEY_LIMIT_NS},
+    [PRINT] = {"print", .limit = JSONBENCH_PRINT_LIMIT_NS},
+};
+
+static uint64_t stageStart;
+static uint32_t stageAllocations;
+
+static void stage_begin(void) {
+    stageAllocations = allocations;
+    stageStart = now_ns();
+}
+
+static void stage_end(stage_t *stage, uint64_t messages, uint64_t bytes) {
+    stage->time += now_ns() - stageStart;
+    stage->allocations += allocations - stageAllocations;
+    stage->messages += messages;
+    stage->bytes += bytes;
+}
+
+/* -------------------------------------------------------------------------- */
+
+/*  Each stage is timed over the whole corpus at once, so the clock overhead
+    is spread out over as many messages as possible. A stage that needs the
+    output of an earlier stage redoes that work outside the timed section.
+*/
+static void run_iteration(void) {
+    uint64_t requestBytes = 0;
+    for (uint8_t i = 0; i < numRequests; i++) {
+        requestBytes += strlen(requestCorpus[i]);
+    }
+
+    // jsmn doesn't modify the message, so the buffers can be reused
+    load_requests();
+    stage_begin();
+    for (uint8_t i = 0; i < numRequests; i++) {
+        json_buffer_t *buf = &buffers[i];
+        jsmn_parser parser;
+
+        jsmn_init(&parser);
+        buf->tokensParsed = jsmn_parse(&parser, buf->data, buf->length,
+                                       buf->tokens, MAX_TOKENS);
+    }
+    stage_end(&stages[PARSE], numRequests, requestBytes);
+
+    // preprocess() needs fresh buffers, because it terminates every token
+    load_requests();
+    stage_begin();
+    for (uint8_t i = 0; i < numRequests; i++) {
+        preprocess(&buffers[i]);
+    }
+    stage_end(&stages[PREPROCESS], numRequests, requestBytes);
+
+    // now every string token is terminated, so they can be hashed again
+    volatile int hashes = 0;
+    stage_begin();
+    for (uint8_t i = 0; i < numRequests; i++) {
+        json_buffer_t *buf = &buffers[i];
+
+        for (uint8_t t = 0; t < buf->tokensParsed; t++) {
+            if (TYPE(t) == JSMN_STRING) {
+                hashes += compute_hash(TOKEN(t));
+            }
+        }
+    }
+    stage_end(&stages[HASH], numRequests, requestBytes);
+
+    volatile uint8_t found = 0;
+    stage_begin();
+    for (uint8_t i = 0; i < numRequests; i++) {
+        found += find_key(&buffers[i], ROOT_OBJECT, hash_message_id);
+    }
+    stage_end(&stages[FIND_KEY], numRequests, 0);
+
+    printedBytes = 0;
+    stage_begin();
+    for (uint8_t i = 0; i < NUM_RESPONSES; i++) {
+        json_print(counting_printer, responseCorpus[i]);
+    }
+    stage_end(&stages[PRINT], NUM_RESPONSES, printedBytes);
+}
+
+/* -------------------------------------------------------------------------- */
+
+// print one stage's results, returns false if it went over a limit
+static bool report(const stage_t *stage) {
+    uint64_t perMessage = stage->time / stage->messages;
+    bool pass = (perMessage <= stage->limit) &&
+                (stage->allocations <= JSONBENCH_ALLOCATION_LIMIT);
+
+    printf("%-11s %8llu %13llu %11lu %8lu  %s\n", stage->name,
+           (unsigned long long)perMessage,
+           (unsigned long long)(stage->time
+                                    ? stage->bytes * 1000000000 / stage->time
+                                    : 0),
+           (unsigned long)stage->allocations, (unsigned long)stage->limit,
+           pass ? "PASS" : "FAIL");
+
+    return pass;
+}
+
+int main(int argc, char **argv) {
+    uint32_t iterations = DEFAULT_ITERATIONS;
+    const char *corpus = DEFAULT_CORPUS;
+
+    if (argc >= 2) {
+        iterations = strtoul(argv[1], NULL, 10);
+    }
+    if (argc >= 3) {
+        corpus = argv[2];
+    }
+    if (iterations == 0) {
+        iterations = 1;
+    }
+
+    if (!load_corpus(corpus)) {
+        return 2;
+    }
+
+    for (uint32_t n = 0; n < iterations; n++) {
+        run_iteration();
+    }
+
+    printf("%lu iterations, %u requests, %u responses\n",
+           (unsigned long)iterations, numRequests, (unsigned)NUM_RESPONSES);
+    printf("%-11s %8s %13s %11s %8s\n", "stage", "ns/msg", "bytes/sec",
+           "allocations", "limit");
+
+    bool pass = true;
+    for (uint8_t i = 0; i < NUM_STAGES; i++) {
+        pass &= report(&stages[i]);
+    }
+
+    return pass ? 0 : 1;
+}
@@ -0,0 +1,231 @@
+#include "log_decode.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+/* ************************************************************************** */
+
+// these must match log_deferred.h and logging.c
+#define MARKER '~'
+#define MAX_ARGS 4
+#define MAX_MESSAGE_SIZE 30
+
+static const char *levelNames[] = {
+    "SILENT", "FATAL", "ERROR", "WARN", "INFO", "DEBUG", "TRACE",
+};
+
+/* -------------------------------------------------------------------------- */
+
+static int hex_value(char c) {
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    }
+    if (c >= 'A' && c <= 'F') {
+        return c - 'A' + 10;
+    }
+    if (c >= 'a' && c <= 'f') {
+        return c - 'a' + 10;
+    }
+    return -1;
+}
+
+// read one varint, returns -1 if the message ran out
+static int get_varint(const uint8_t *message, size_t length, size_t *position,
+                      uint32_t *value) {
+    *value = 0;
+
+    for (uint8_t shift = 0; shift < 35; shift += 7) {
+        if (*position >= length) {
+            return -1;
+        }
+
+        uint8_t byte = message[(*position)++];
+        *value |= (uint32_t)(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) {
+            return 0;
+        }
+    }
+
+    return -1;
+}
+
+/* -------------------------------------------------------------------------- */
+
+typedef struct {
+    char *output;
+    size_t size;
+    size_t length;
+    int overflow;
+} writer_t;
+
+// track the result of an snprintf() into the rest of the output
+static void advance(writer_t *writer, int written) {
+    if (written < 0 || (size_t)written >= writer->size - writer->length) {
+        writer->overflow = 1;
+        return;
+    }
+    writer->length += written;
+}
+
+// the arguments snprintf() needs to write to the rest of the output
+#define REMAINING(writer)                                                      \
+    &(writer)->output[(writer)->length], (writer)->size - (writer)->length
+
+/*  Render one conversion, like "%-4u" or "%lx", with the given value.
+
+    The value was stored as a uint32_t, so it gets converted back to whatever
+    type the conversion expected on the PIC before it's printed.
+*/
+static void render_conversion(writer_t *writer, const char *start,
+                              size_t length, uint32_t value) {
+    char spec[16];
+    char conversion = start[length - 1];
+    char modifier = (length >= 3) ? start[length - 2] : 0;
+    int isLong = (modifier == 'l');
+    int hasModifier = (modifier == 'l' || modifier == 'h');
+
+    if (length >= sizeof(spec) - 2) {
+        writer->overflow = 1;
+        return;
+    }
+
+    // rebuild the conversion with an 'l', so every value can be a long
+    size_t prefix = length - 1 - hasModifier;
+    memcpy(spec, start, prefix);
+    if (conversion != 'c') {
+        spec[prefix++] = 'l';
+    }
+    spec[prefix++] = conversion;
+    spec[prefix] = '\0';
+
+    switch (conversion) {
+    case 'd':
+    case 'i':
+        if (isLong) {
+            long signedValue = (int32_t)value;
+            advance(writer, snprintf(REMAINING(writer), spec, signedValue));
+        } else {
+            long signedValue = (int16_t)value;
+            advance(writer, snprintf(REMAINING(writer), spec, signedValue));
+        }
+        return;
+    case 'u':
+    case 'x':
+    case 'X':
+    case 'o':
+        if (!isLong) {
+            value &= 0xffff;
+        }
+        advance(writer,
+                snprintf(REMAINING(writer), spec, (unsigned long)value));
+        return;
+    case 'c':
+        // a NUL would end the decoded line early, so show it escaped
+        if ((char)value == '\0') {
+            advance(writer, snprintf(REMAINING(writer), "\\0"));
+            return;
+        }
+        advance(writer, snprintf(REMAINING(writer), spec, (int)(char)value));
+        return;
+    default:
+        advance(writer, snprintf(REMAINING(writer), "?"));
+        return;
+    }
+}
+
+// render 'format' with the stored argument values
+static void render_message(writer_t *writer, const char *format,
+                           const uint32_t *args, uint8_t count) {
+    uint8_t arg = 0;
+
+    while (*format && !writer->overflow) {
+        if (*format != '%') {
+            advance(writer, snprintf(REMAINING(writer), "%c", *format++));
+            continue;
+        }
+
+        if (format[1] == '%') {
+            advance(writer, snprintf(REMAINING(writer), "%%"));
+            format += 2;
+            continue;
+        }
+
+        // flags, width, precision, length, conversion
+        size_t length = 1;
+        while (format[length] && strchr("-+ #0123456789.", format[length])) {
+            length++;
+        }
+        if (format[length] == 'l' || format[length] == 'h') {
+            length++;
+        }
+        if (!format[length]) {
+            return;
+        }
+        length++;
+
+        uint32_t value = (arg < count) ? args[arg] : 0;
+        arg++;
+
+        render_conversion(writer, format, length, value);
+        format += length;
+    }
+}
+
+/* ************************************************************************** */
+
+long log_decode(const char *line, char *output, size_t outputSize) {
+    uint8_t message[MAX_MESSAGE_SIZE];
+    size_t length = 0;
+
+    if (!line || line[0] != MARKER || outputSize == 0) {
+        return -1;
+    }
+
+    // unpack the hex, stopping at the end of the line
+    for (const char *c = &line[1]; hex_value(c[0]) >= 0; c += 2) {
+        if (hex_value(c[1]) < 0 || length >= MAX_MESSAGE_SIZE) {
+            return -1;
+        }
+        message[length++] = (hex_value(c[0]) << 4) | hex_value(c[1]);
+    }
+
+    size_t position = 0;
+    uint32_t id;
+    uint32_t timestamp;
+    uint32_t args[MAX_ARGS];
+    uint8_t count = 0;
+
+    if (get_varint(message, length, &position, &id) ||
+        get_varint(message, length, &position, &timestamp)) {
+        return -1;
+    }
+    while (position < length) {
+        if (count >= MAX_ARGS ||
+            get_varint(message, length, &position, &args[count++])) {
+            return -1;
+        }
+    }
+
+    if (id >= logDictionaryLength) {
+        return -1;
+    }
+    const log_dictionary_entry_t *site = &logDictionary[id];
+    if (site->level >= sizeof(levelNames) / sizeof(levelNames[0])) {
+        return -1;
+    }
+
+    writer_t writer = {output, outputSize, 0, 0};
+    output[0] = '\0';
+
+    advance(&writer, snprintf(REMAINING(&writer), "%lu %-6s %s:%u: ",
+                              (unsigned long)timestamp,
+                              levelNames[site->level], site->file,
+                              site->line));
+    render_message(&writer, site->format, args, count);
+
+    if (writer.overflow) {
+        return -1;
+    }
+    return writer.length;
+}
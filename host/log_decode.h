@@ -0,0 +1,46 @@
+#ifndef _LOG_DECODE_H_
+#define _LOG_DECODE_H_
+
+/* ************************************************************************** */
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* ************************************************************************** */
+/*  Decoder for the messages sent by log_deferred.c
+
+    This file is meant for the host side of the link. It only depends on the
+    generated dictionary, log_dictionary.c, and it's plain C99, so both files
+    can be dropped into a host tool or wrapped by a scripting language's FFI.
+    The dictionary has to come from the same build as the firmware.
+
+    'line' is one line of console output, starting with the '~' marker. The
+    decoded message is written to 'output' and null terminated, formatted the
+    same way as LOG_XXX() messages:
+
+        <timestamp> <LEVEL> <path/to/source/file.c:line#>: <message>
+
+    Returns the length of the decoded text, or -1 if the line isn't a deferred
+    log message, is corrupt, has an unknown ID, or doesn't fit in 'output'.
+
+    The firmware is compiled by XC8, where an int is 16 bits, so conversions
+    without an 'l' are rendered as 16 bit values. A %c with a value of 0 is
+    rendered as "\0", so it can't end the output early.
+*/
+extern long log_decode(const char *line, char *output, size_t outputSize);
+
+/* -------------------------------------------------------------------------- */
+
+// one log site, see log_deferred.h
+typedef struct {
+    uint8_t level;
+    const char *file;
+    uint16_t line;
+    const char *format;
+} log_dictionary_entry_t;
+
+// generated by log_deferred.h, indexed by site ID
+extern const log_dictionary_entry_t logDictionary[];
+extern const uint16_t logDictionaryLength;
+
+#endif // _LOG_DECODE_H_
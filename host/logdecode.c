@@ -0,0 +1,66 @@
+#include "log_decode.h"
+#include <stdio.h>
+#include <string.h>
+
+/* ************************************************************************** */
+/*  logdecode: turn deferred log messages in a console capture back into text
+
+    Reads a capture from a file, or from stdin, and prints it with every '~'
+    line replaced by the message it stands for. Everything else is passed
+    through untouched, so regular log messages and shell output stay in
+    order with the deferred ones.
+
+    A line that can't be decoded is passed through as well, with a note, which
+    usually means the dictionary didn't come from the same build.
+
+    Usage:
+        $ ./build/logdecode [capture file]
+        $ picocom -b 115200 /dev/ttyUSB0 | ./build/logdecode
+*/
+
+// these must match channel_mux.h
+#define CHANNEL_TAG_FIRST 0x1C
+#define CHANNEL_TAG_LAST 0x1E
+
+#define MAX_LINE_LENGTH 512
+
+int main(int argc, char **argv) {
+    FILE *input = stdin;
+
+    if (argc > 1) {
+        input = fopen(argv[1], "r");
+        if (!input) {
+            printf("can't open capture file: %s\n", argv[1]);
+            return 1;
+        }
+    }
+
+    char line[MAX_LINE_LENGTH];
+    char decoded[MAX_LINE_LENGTH];
+
+    while (fgets(line, sizeof(line), input)) {
+        // skip any channel tags, the multiplexer sends one before a log line
+        char *start = line;
+        while (*start >= CHANNEL_TAG_FIRST && *start <= CHANNEL_TAG_LAST) {
+            start++;
+        }
+
+        if (start[0] != '~') {
+            fputs(line, stdout);
+            continue;
+        }
+
+        start[strcspn(start, "\r\n")] = '\0';
+        if (log_decode(start, decoded, sizeof(decoded)) < 0) {
+            printf("%s (can't decode)\n", start);
+            continue;
+        }
+        printf("%s\n", decoded);
+        fflush(stdout);
+    }
+
+    if (input != stdin) {
+        fclose(input);
+    }
+    return 0;
+}
@@ -0,0 +1,24 @@
+#include "hash_function.h"
+#include <stdint.h>
+#include <string.h>
+
+/* ************************************************************************** */
+
+static const struct hash {
+    const char *name;
+    hash_value_t value;
+} words[] = {
+    {"message_id", hash_message_id},
+    {"compression", hash_compression},
+    {"shell", hash_shell},
+    {"device_info", hash_device_info},
+};
+
+hash_value_t compute_hash(const char *string) {
+    for (uint8_t i = 0; i < sizeof(words) / sizeof(words[0]); i++) {
+        if (strcmp(string, words[i].name) == 0) {
+            return words[i].value;
+        }
+    }
+    return -1;
+}
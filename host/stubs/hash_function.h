@@ -0,0 +1,28 @@
+#ifndef _HASH_FUNCTION_H_
+#define _HASH_FUNCTION_H_
+
+/* ************************************************************************** */
+/*  Host stand-in for the hash function that judi/hash.h generates with gperf
+
+    The real key list comes from the project's usb/messages.c, which isn't
+    part of os/. This covers the keys os/ looks up itself. If
+    judi/hash_function.c has been generated, the Makefile uses that instead.
+*/
+
+#include <stdint.h>
+
+typedef enum {
+    jsmn_undefined = 0,
+    jsmn_object = 1,
+    jsmn_array = 2,
+    jsmn_string = 3,
+    jsmn_primitive = 4,
+    hash_message_id = 5,
+    hash_compression = 6,
+    hash_shell = 7,
+    hash_device_info = 8,
+} hash_value_t;
+
+extern hash_value_t compute_hash(const char *string);
+
+#endif // _HASH_FUNCTION_H_
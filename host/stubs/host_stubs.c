@@ -0,0 +1,31 @@
+#include "os/serial_port.h"
+#include "os/system_time.h"
+#include "os/usb_port.h"
+#include "peripherals/device_information.h"
+#include <stdint.h>
+#include <time.h>
+
+/* ************************************************************************** */
+/*  Host stand-ins for the hardware-facing functions that os/ calls
+
+    The USB and serial ports throw everything away, so only the cost of
+    producing the output is measured, and the system tick follows the host's
+    clock.
+*/
+
+char hexMUI[] = "0123456789ABCDEF";
+
+system_time_t get_current_time(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return now.tv_sec * 1000 + now.tv_nsec / 1000000;
+}
+
+void usb_putch(char data) {}
+
+void usb_print(const char *string) {}
+
+void usb_println(const char *string) {}
+
+void print(const char *string) {}
@@ -0,0 +1,18 @@
+#ifndef _LOG_SITES_H_
+#define _LOG_SITES_H_
+
+/* ************************************************************************** */
+/*  Host stand-in for the site IDs that log_deferred.h generates with cog
+
+    log_deferred.c only refers to the reserved ID for the dropped message
+    count, which is always 0. test_log_decode.c uses plain numbers for
+    everything else, so this works with a generated log_sites.h too.
+*/
+
+#include <stdint.h>
+
+typedef enum {
+    dlog_dropped = 0,
+} log_site_t;
+
+#endif // _LOG_SITES_H_
@@ -0,0 +1,10 @@
+#ifndef _DEVICE_INFORMATION_H_
+#define _DEVICE_INFORMATION_H_
+
+/* ************************************************************************** */
+// Host stand-in for the device information peripheral
+
+// the unit's serial number, as a hex string
+extern char hexMUI[];
+
+#endif // _DEVICE_INFORMATION_H_
@@ -0,0 +1,28 @@
+#ifndef _UART_H_
+#define _UART_H_
+
+/* ************************************************************************** */
+/*  Host stand-in for the peripherals UART driver
+
+    Only the parts of the interface that the os/ code touches. Nothing here
+    talks to real hardware.
+*/
+
+#include <stdint.h>
+
+typedef struct {
+    uint8_t channel;
+} uart_config_t;
+
+typedef struct {
+    void (*tx_char)(char data);
+    void (*tx_string)(const char *string, char terminator);
+    char (*rx_char)(void);
+    uint16_t (*tx_space)(void); // free bytes in the TX buffer
+} uart_interface_t;
+
+#define EMPTY_UART_INTERFACE(name) uart_interface_t name = {0}
+
+extern uart_interface_t UART_init(uart_config_t *config);
+
+#endif // _UART_H_
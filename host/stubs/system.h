@@ -0,0 +1,7 @@
+#ifndef _SYSTEM_H_
+#define _SYSTEM_H_
+
+/* ************************************************************************** */
+// Host stand-in for the project's system.h
+
+#endif // _SYSTEM_H_
@@ -0,0 +1,7 @@
+#ifndef _MESSAGES_H_
+#define _MESSAGES_H_
+
+/* ************************************************************************** */
+// Host stand-in for the project's JUDI message handlers
+
+#endif // _MESSAGES_H_
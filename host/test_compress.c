@@ -0,0 +1,122 @@
+#include "os/json/json_compress.h"
+#include "os/json/json_decompress.h"
+#include "os/json/json_print.h"
+#include "os/judi/judi_messages.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+/* ************************************************************************** */
+/*  json_compress.c and json_decompress.c tests
+
+    Compresses some text, decodes it again, and checks that it came back
+    unchanged and that the decoder stopped exactly at the end of the stream.
+*/
+
+static uint8_t compressed[2048];
+static size_t compressedLength;
+
+static void capture(char c) {
+    if (compressedLength < sizeof(compressed)) {
+        compressed[compressedLength++] = c;
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+
+static uint8_t failures;
+
+static void check(const char *name, const char *expected) {
+    char output[2048];
+    size_t consumed = 0;
+
+    long length = json_decompress(compressed, compressedLength, output,
+                                  sizeof(output), &consumed);
+
+    if (length != (long)strlen(expected) || strcmp(output, expected) != 0 ||
+        consumed != compressedLength) {
+        printf("FAIL %s\n  expected %u bytes [%s]\n  got      %ld bytes [%s], "
+               "used %u of %u bytes\n",
+               name, (unsigned)strlen(expected), expected, length,
+               length < 0 ? "" : output, (unsigned)consumed,
+               (unsigned)compressedLength);
+        failures++;
+        return;
+    }
+    printf("PASS %s, %u -> %u bytes\n", name, (unsigned)strlen(expected),
+           (unsigned)compressedLength);
+}
+
+// compress 'text', written in pieces of 'pieceSize' bytes
+static void round_trip(const char *name, const char *text, size_t pieceSize) {
+    json_compressor_t compressor;
+    char piece[64];
+
+    compressedLength = 0;
+    json_compress_begin(&compressor, capture);
+    for (size_t i = 0; i < strlen(text); i += pieceSize) {
+        strncpy(piece, &text[i], pieceSize);
+        piece[pieceSize] = '\0';
+        json_compress_write(&compressor, piece);
+    }
+    json_compress_end(&compressor);
+
+    check(name, text);
+}
+
+/* -------------------------------------------------------------------------- */
+
+static const char traffic[] = //
+    "{\"update\":{\"log\":{\"level\":\"info\",\"file\":\"judi.c\",\"line\":141}}}"
+    "{\"update\":{\"log\":{\"level\":\"info\",\"file\":\"judi.c\",\"line\":208}}}"
+    "{\"update\":{\"status\":{\"time\":104233,\"mode\":\"auto\",\"temp\":21}}}"
+    "{\"update\":{\"status\":{\"time\":104733,\"mode\":\"auto\",\"temp\":21}}}"
+    "{\"message_id\":17,\"response\":\"ok\"}"
+    "{\"message_id\":18,\"response\":\"ok\"}";
+
+// longer than the ring, with nothing for the compressor to match
+static char noise[600];
+
+static char plain[512];
+
+static void capture_plain(const char *string) {
+    strncat(plain, string, sizeof(plain) - strlen(plain) - 1); //
+}
+
+int main(void) {
+    round_trip("empty", "", 1);
+    round_trip("one byte", "{", 1);
+    round_trip("shorter than a match", "{}", 1);
+    round_trip("overlapping match", "aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa", 5);
+    round_trip("traffic, one byte at a time", traffic, 1);
+    round_trip("traffic, in pieces", traffic, 13);
+    round_trip("traffic, in large pieces", traffic, 63);
+
+    uint32_t seed = 1;
+    for (size_t i = 0; i < sizeof(noise) - 1; i++) {
+        seed = seed * 1103515245 + 12345;
+        noise[i] = ' ' + (seed >> 16) % 95;
+    }
+    round_trip("incompressible text", noise, 40);
+
+    // a whole node list, compressed as it is printed
+    json_print(capture_plain, deviceInfo);
+    compressedLength = 0;
+    json_print_compressed(capture, deviceInfo);
+    check("json_print_compressed(deviceInfo)", plain);
+
+    // a truncated stream has to be reported, not decoded
+    compressedLength--;
+    char output[512];
+    size_t consumed;
+    if (json_decompress(compressed, compressedLength, output, sizeof(output),
+                        &consumed) != -1) {
+        printf("FAIL truncated stream was decoded\n");
+        failures++;
+    } else {
+        printf("PASS truncated stream\n");
+    }
+
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,132 @@
+#include "os/json/json_delta.h"
+#include "os/judi/judi_messages.h"
+#include "os/judi/message_id.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+/* ************************************************************************** */
+/*  json_delta.c tests
+
+    Sends a status update built on the real updatePreamble, the way a project
+    would, and checks what actually goes out the port.
+*/
+
+static char output[256];
+
+static void capture(const char *string) {
+    strncat(output, string, sizeof(output) - strlen(output) - 1); //
+}
+
+static uint16_t temperature = 21;
+static uint16_t speed = 1200;
+
+static const json_node_t statusUpdate[] = {
+    {nNodeList, (void *)updatePreamble}, //
+    {nKey, "mode"},                      //
+    {nString, "auto"},                   //
+    {nKey, "temperature"},               //
+    {nU16, (void *)&temperature},        //
+    {nKey, "speed"},                     //
+    {nU16, (void *)&speed},              //
+    {nControl, "\e"},                    //
+};
+
+JSON_DELTA(statusDelta, statusUpdate, 8, 4);
+
+/* -------------------------------------------------------------------------- */
+
+// a delta that's printed from inside another delta's nFunction callback
+static char innerOutput[64];
+
+static void capture_inner(const char *string) {
+    strncat(innerOutput, string,
+            sizeof(innerOutput) - strlen(innerOutput) - 1); //
+}
+
+static uint16_t level = 3;
+
+static const json_node_t innerUpdate[] = {
+    {nControl, "{"},        //
+    {nKey, "level"},        //
+    {nU16, (void *)&level}, //
+    {nControl, "\e"},       //
+};
+
+JSON_DELTA(innerDelta, innerUpdate, 2, 0);
+
+static const json_node_t *print_inner(void) {
+    json_delta_print(capture_inner, &innerDelta);
+    return NULL;
+}
+
+static const node_function_t innerFunction = {print_inner};
+
+static const json_node_t outerUpdate[] = {
+    {nNodeList, (void *)updatePreamble}, //
+    {nKey, "speed"},                     //
+    {nU16, (void *)&speed},              //
+    {nFunction, (void *)&innerFunction}, //
+    {nControl, "\e"},                    //
+};
+
+JSON_DELTA(outerDelta, outerUpdate, 2, 0);
+
+/* -------------------------------------------------------------------------- */
+
+static uint8_t failures;
+
+static void expect_delta(const char *name, json_delta_t *delta, bool printed,
+                         const char *expected) {
+    output[0] = '\0';
+    bool result = json_delta_print(capture, delta);
+
+    if (result != printed || strcmp(output, expected) != 0) {
+        printf("FAIL %s\n  expected %d [%s]\n  got      %d [%s]\n", name,
+               printed, expected, result, output);
+        failures++;
+        return;
+    }
+    printf("PASS %s\n", name);
+}
+
+static void expect(const char *name, bool printed, const char *expected) {
+    expect_delta(name, &statusDelta, printed, expected); //
+}
+
+int main(void) {
+    // these are updates, not responses to anything
+    set_need_to_send(false);
+
+    expect("first message is complete", true,
+           "{\"update\":{\"mode\":\"auto\",\"temperature\":21,\"speed\":1200}}");
+
+    expect("nothing changed", false, "");
+
+    temperature = 22;
+    expect("only the changed member is sent", true,
+           "{\"update\":{\"temperature\":22}}");
+
+    temperature = 23;
+    speed = 1300;
+    expect("members after the first get commas", true,
+           "{\"update\":{\"temperature\":23,\"speed\":1300}}");
+
+    expect("keyframe sends everything", true,
+           "{\"update\":{\"mode\":\"auto\",\"temperature\":23,\"speed\":1300}}");
+
+    json_delta_reset(&statusDelta);
+    expect("reset sends everything", true,
+           "{\"update\":{\"mode\":\"auto\",\"temperature\":23,\"speed\":1300}}");
+
+    innerOutput[0] = '\0';
+    expect_delta("a delta inside another one", &outerDelta, true,
+                 "{\"update\":{\"speed\":1300}}");
+    if (strcmp(innerOutput, "{\"level\":3}") != 0) {
+        printf("FAIL the inner delta printed [%s]\n", innerOutput);
+        failures++;
+    }
+
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,166 @@
+#include "log_decode.h"
+#include "os/channel_mux.h"
+#include "os/log_deferred.h"
+#include "os/logging.h"
+#include "os/system_time.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+/* ************************************************************************** */
+/*  log_deferred.c and log_decode.c tests
+
+    Stores messages with the firmware's encoder, drains them through a fake
+    serial port, and checks that log_decode() turns each line back into the
+    text the log site was written for.
+
+    The dictionary is made up here, instead of being generated, so the site
+    IDs are plain numbers.
+*/
+
+const log_dictionary_entry_t logDictionary[] = {
+    {L_WARN, "log_deferred.c", 0, "%lu messages dropped"},
+    {L_INFO, "tuning.c", 500, "freq: %u, swr: %u"},
+    {L_DEBUG, "records.c", 61, "signed %d, long %ld, hex %04x, char %c"},
+    {L_TRACE, "big.c", 7, "big %lu, small %u"},
+    {L_ERROR, "none.c", 1, "no arguments, 100%% sure"},
+};
+
+const uint16_t logDictionaryLength =
+    sizeof(logDictionary) / sizeof(logDictionary[0]);
+
+/* -------------------------------------------------------------------------- */
+
+// stand-ins for the parts of the OS that log_deferred.c talks to
+
+static system_time_t now = 60902;
+
+system_time_t get_current_time(void) { return now; }
+
+static uint16_t txSpace = UINT16_MAX;
+
+uint16_t serial_port_tx_space(void) { return txSpace; }
+
+channel_t channel_mux_select(channel_t channel) { return channel; }
+
+#define MAX_LINES 40
+
+static char lines[MAX_LINES][80];
+static uint8_t lineCount;
+
+void println(const char *string) {
+    if (lineCount < MAX_LINES) {
+        strncpy(lines[lineCount], string, sizeof(lines[0]) - 1);
+    }
+    lineCount++;
+}
+
+/* -------------------------------------------------------------------------- */
+
+static uint8_t failures;
+
+// drain everything that's stored, and check the decoded lines in order
+static void expect(const char *name, const char **expected, uint8_t count) {
+    lineCount = 0;
+    attempt_log_drain();
+
+    if (lineCount != count) {
+        printf("FAIL %s\n  expected %u lines, got %u\n", name, count,
+               lineCount);
+        failures++;
+        return;
+    }
+
+    for (uint8_t i = 0; i < count; i++) {
+        char decoded[128];
+
+        long length = log_decode(lines[i], decoded, sizeof(decoded));
+        if (length != (long)strlen(expected[i]) ||
+            strcmp(decoded, expected[i]) != 0) {
+            printf("FAIL %s, line %u [%s]\n  expected [%s]\n  got      "
+                   "[%s]\n",
+                   name, i, lines[i], expected[i], length < 0 ? "" : decoded);
+            failures++;
+            return;
+        }
+    }
+    printf("PASS %s\n", name);
+}
+
+static void store(uint16_t id, uint32_t a, uint32_t b, uint32_t c, uint32_t d,
+                  uint8_t count) {
+    const uint32_t args[] = {a, b, c, d};
+    log_defer__(id, args, count);
+}
+
+/* -------------------------------------------------------------------------- */
+
+int main(void) {
+    store(1, 7000, 150, 0, 0, 2);
+    const char *oneMessage[] = {
+        "60902 INFO   tuning.c:500: freq: 7000, swr: 150",
+    };
+    expect("one message", oneMessage, 1);
+
+    // negative values are stored the way a cast to uint32_t leaves them
+    int16_t signedValue = -5;
+    int32_t longValue = -100000;
+    store(2, (uint32_t)signedValue, (uint32_t)longValue, 0xbeef, 'x', 4);
+    now = 0;
+    store(4, 0, 0, 0, 0, 0);
+    now = UINT32_MAX;
+    store(3, UINT32_MAX, 0x12345, 0, 0, 2);
+    const char *everyType[] = {
+        "60902 DEBUG  records.c:61: signed -5, long -100000, hex beef, char x",
+        "0 ERROR  none.c:1: no arguments, 100% sure",
+        "4294967295 TRACE  big.c:7: big 4294967295, small 9029",
+    };
+    expect("every kind of argument", everyType, 3);
+
+    // nothing goes out until the serial port has room for a whole line
+    now = 1000;
+    txSpace = 0;
+    store(1, 1, 2, 0, 0, 2);
+    expect("no room to drain", NULL, 0);
+    txSpace = UINT16_MAX;
+    const char *waited[] = {
+        "1000 INFO   tuning.c:500: freq: 1, swr: 2",
+    };
+    expect("drained once there's room", waited, 1);
+
+    // each of these takes 7 bytes, so 36 of them fill the 255 usable bytes
+    now = 60902;
+    txSpace = 0;
+    for (uint8_t i = 0; i < 40; i++) {
+        store(1, 100, 0, 0, 0, 2);
+    }
+    txSpace = UINT16_MAX;
+    lineCount = 0;
+    attempt_log_drain();
+    if (lineCount != 36) {
+        printf("FAIL full ring\n  expected 36 lines, got %u\n", lineCount);
+        failures++;
+    } else {
+        printf("PASS full ring\n");
+    }
+
+    store(1, 3, 4, 0, 0, 2);
+    const char *dropped[] = {
+        "60902 WARN   log_deferred.c:0: 4 messages dropped",
+        "60902 INFO   tuning.c:500: freq: 3, swr: 4",
+    };
+    expect("dropped messages are counted", dropped, 2);
+
+    // a line that doesn't decode has to be reported
+    char decoded[128];
+    if (log_decode("~7F00", decoded, sizeof(decoded)) != -1 ||
+        log_decode("~0C8", decoded, sizeof(decoded)) != -1 ||
+        log_decode("~0100", decoded, 8) != -1) {
+        printf("FAIL bad lines were decoded\n");
+        failures++;
+    } else {
+        printf("PASS bad lines\n");
+    }
+
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,156 @@
+#include "os/json/json_print.h"
+#include "os/json/json_step.h"
+#include "os/judi/judi_messages.h"
+#include "os/judi/message_id.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+/* ************************************************************************** */
+/*  json_step.c tests
+
+    Prints each node list with json_print(), then again with json_print_step()
+    at a range of byte budgets, and checks that the two outputs are identical.
+*/
+
+static char output[512];
+
+static void capture(const char *string) {
+    strncat(output, string, sizeof(output) - strlen(output) - 1); //
+}
+
+/* -------------------------------------------------------------------------- */
+
+static uint16_t temperature = 21;
+static uint32_t uptime = 104233;
+static float voltage = 13.8;
+
+static const json_node_t batteryInfo[] = {
+    {nKey, "voltage"},                   //
+    {nFloat, (void *)&voltage},          //
+    {nKey, "chemistry"},                 //
+    {nString, "lithium iron phosphate"}, //
+    {nControl, "\e"},                    //
+};
+
+static const json_node_t nestedInfo[] = {
+    {nControl, "{"},                  //
+    {nKey, "status"},                 //
+    {nControl, "{"},                  //
+    {nKey, "temperature"},            //
+    {nU16, (void *)&temperature},     //
+    {nKey, "battery"},                //
+    {nControl, "{"},                  //
+    {nNodeList, (void *)batteryInfo}, //
+    {nControl, "}"},                  //
+    {nKey, "uptime"},                 //
+    {nU32, (void *)&uptime},          //
+    {nControl, "}"},                  //
+    {nKey, "mode"},                   //
+    {nString, "auto"},                //
+    {nControl, "\e"},                 //
+};
+
+/* -------------------------------------------------------------------------- */
+
+static bool includeBattery = true;
+
+static const json_node_t *get_battery(void) {
+    if (includeBattery) {
+        return batteryInfo;
+    }
+    return NULL;
+}
+
+static const node_function_t batteryFunction = {get_battery};
+
+static const json_node_t functionInfo[] = {
+    {nControl, "{"},                       //
+    {nKey, "temperature"},                 //
+    {nU16, (void *)&temperature},          //
+    {nFunction, (void *)&batteryFunction}, //
+    {nKey, "mode"},                        //
+    {nString, "auto"},                     //
+    {nControl, "\e"},                      //
+};
+
+static const json_node_t functionFirst[] = {
+    {nControl, "{"},                       //
+    {nFunction, (void *)&batteryFunction}, //
+    {nKey, "mode"},                        //
+    {nString, "auto"},                     //
+    {nControl, "\e"},                      //
+};
+
+static const json_node_t fullResponse[] = {
+    {nNodeList, (void *)responsePreamble}, //
+    {nNodeList, (void *)deviceInfo},       //
+    {nControl, "\e"},                      //
+};
+
+/* -------------------------------------------------------------------------- */
+
+static uint8_t failures;
+
+// the message id is only sent once, so it has to be asked for before each run
+static bool withMessageId = false;
+
+static void start(void) {
+    output[0] = '\0';
+    set_need_to_send(withMessageId);
+}
+
+// budgets that split pieces in every possible place, plus one that never does
+static const uint16_t budgets[] = {1, 2, 3, 7, 16, 17, 64, UINT16_MAX};
+
+#define NUMBER_OF_BUDGETS (sizeof(budgets) / sizeof(budgets[0]))
+
+static void compare(const char *name, const json_node_t *nodeList) {
+    char expected[sizeof(output)];
+
+    start();
+    json_print(capture, nodeList);
+    strcpy(expected, output);
+
+    for (uint8_t i = 0; i < NUMBER_OF_BUDGETS; i++) {
+        json_step_t step;
+        uint16_t calls = 0;
+
+        start();
+        json_step_begin(&step, capture, nodeList);
+        while (!json_print_step(&step, budgets[i])) {
+            // something's wrong if it never finishes
+            if (++calls > sizeof(output)) {
+                break;
+            }
+        }
+
+        if (step.overflow || strcmp(output, expected) != 0) {
+            printf("FAIL %s, %u bytes per step\n  expected [%s]\n  got      "
+                   "[%s]%s\n",
+                   name, budgets[i], expected, output,
+                   step.overflow ? " (overflow)" : "");
+            failures++;
+            return;
+        }
+    }
+    printf("PASS %s\n", name);
+}
+
+int main(void) {
+    compare("deviceInfo", deviceInfo);
+    compare("nested lists and objects", nestedInfo);
+    compare("function node with contents", functionInfo);
+    compare("function node first in an object", functionFirst);
+
+    includeBattery = false;
+    compare("function node with no contents", functionInfo);
+    compare("empty function node first in an object", functionFirst);
+
+    set_message_id(17);
+    withMessageId = true;
+    compare("response with a message id", fullResponse);
+
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,148 @@
+#include "json_compress.h"
+#include "json_print.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+/* ************************************************************************** */
+
+// the number of bits used by each field of a token
+#define DISTANCE_BITS 7
+#define LENGTH_BITS 4
+
+/* -------------------------------------------------------------------------- */
+
+// add the lowest 'count' bits of 'value' to the output, MSB first
+static void put_bits(json_compressor_t *compressor, uint8_t value,
+                     uint8_t count) {
+    while (count--) {
+        compressor->bits <<= 1;
+        compressor->bits |= (value >> count) & 1;
+
+        if (++compressor->numBits == 8) {
+            compressor->sink(compressor->bits);
+            compressor->bytesOut++;
+            compressor->bits = 0;
+            compressor->numBits = 0;
+        }
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+
+/*  Compress one token from the front of the lookahead.
+
+    This is a brute force search: every possible distance is tried, and the
+    longest match wins. The window is small enough that this is cheaper than
+    maintaining any kind of index, and it doesn't need any extra RAM.
+
+    Because the ring is exactly 256 bytes long, every index is a uint8_t and
+    wraps around all by itself.
+*/
+static void compress_token(json_compressor_t *compressor) {
+    const char *ring = compressor->ring;
+    uint8_t head = compressor->head;
+    uint8_t bestLength = 0;
+    uint8_t bestDistance = 0;
+
+    for (uint8_t distance = 1; distance <= compressor->history; distance++) {
+        uint8_t start = head - distance;
+
+        // cheap rejection before doing a full comparison
+        if (ring[start] != ring[head]) {
+            continue;
+        }
+
+        uint8_t length = 1;
+        while (length < compressor->lookahead) {
+            if (ring[(uint8_t)(start + length)] !=
+                ring[(uint8_t)(head + length)]) {
+                break;
+            }
+            length++;
+        }
+
+        if (length > bestLength) {
+            bestLength = length;
+            bestDistance = distance;
+
+            if (length == compressor->lookahead) {
+                break; // can't do any better than this
+            }
+        }
+    }
+
+    if (bestLength >= JSON_COMPRESS_MIN_MATCH) {
+        put_bits(compressor, 1, 1);
+        put_bits(compressor, bestDistance, DISTANCE_BITS);
+        put_bits(compressor, bestLength - JSON_COMPRESS_MIN_MATCH, LENGTH_BITS);
+    } else {
+        bestLength = 1;
+        put_bits(compressor, 0, 1);
+        put_bits(compressor, ring[head], 8);
+    }
+
+    compressor->head += bestLength;
+    compressor->lookahead -= bestLength;
+
+    if (compressor->history + bestLength > JSON_COMPRESS_WINDOW_SIZE) {
+        compressor->history = JSON_COMPRESS_WINDOW_SIZE;
+    } else {
+        compressor->history += bestLength;
+    }
+}
+
+/* ************************************************************************** */
+
+void json_compress_begin(json_compressor_t *compressor, byte_sink_t sink) {
+    memset(compressor, 0, sizeof(json_compressor_t));
+
+    compressor->sink = sink;
+}
+
+void json_compress_write(json_compressor_t *compressor, const char *string) {
+    while (*string) {
+        uint8_t tail = compressor->head + compressor->lookahead;
+        compressor->ring[tail] = *string++;
+        compressor->lookahead++;
+        compressor->bytesIn++;
+
+        // wait until a full length match is possible before compressing
+        if (compressor->lookahead == JSON_COMPRESS_MAX_MATCH) {
+            compress_token(compressor);
+        }
+    }
+}
+
+void json_compress_end(json_compressor_t *compressor) {
+    while (compressor->lookahead) {
+        compress_token(compressor);
+    }
+
+    // end marker
+    put_bits(compressor, 1, 1);
+    put_bits(compressor, 0, DISTANCE_BITS);
+
+    // pad out the last byte
+    if (compressor->numBits) {
+        put_bits(compressor, 0, 8 - compressor->numBits);
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+
+// json_print() can only hand us a string, so this is how it finds the stream
+static json_compressor_t *current;
+
+static void compress_string(const char *string) {
+    json_compress_write(current, string); //
+}
+
+void json_print_compressed(byte_sink_t sink, const json_node_t *nodeList) {
+    json_compressor_t compressor;
+
+    current = &compressor;
+    json_compress_begin(&compressor, sink);
+    json_print(compress_string, nodeList);
+    json_compress_end(&compressor);
+}
@@ -0,0 +1,90 @@
+#ifndef _JSON_COMPRESS_H_
+#define _JSON_COMPRESS_H_
+
+/* ************************************************************************** */
+
+#include "json_node.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+/* ************************************************************************** */
+/*  Streaming LZ compression
+
+    Large JUDI responses are extremely repetitive. A log dump or a table export
+    sends the same handful of keys over and over, and at 115200 baud, every
+    byte we don't send is time we get back.
+
+    This is a small LZSS compressor. It remembers the last 127 bytes it's seen,
+    and whenever the upcoming text matches something in that window, it sends
+    a short back-reference instead of the text itself. Everything works one
+    byte at a time, so it can sit between json_print() and the UART without
+    buffering the whole message.
+
+    The compressed stream is a sequence of bits, packed MSB first:
+
+        literal:    0 <8 bit character>
+        match:      1 <7 bit distance> <4 bit length - 3>
+        end:        1 0000000
+
+    A match copies 'length' bytes (3 to 18) starting 'distance' bytes (1 to
+    127) back from the current position. The copy is allowed to overlap the
+    bytes it's producing, so "aaaaaa" can be sent as one 'a' and a match with
+    distance 1. A distance of zero marks the end of the stream, and the last
+    byte is padded with zeros.
+
+    The whole compressor needs a little under 300 bytes of RAM. See
+    json_decompress.h for the matching decoder.
+*/
+
+// the longest distance a match can reach back
+#define JSON_COMPRESS_WINDOW_SIZE 127
+
+// the shortest and longest possible matches
+#define JSON_COMPRESS_MIN_MATCH 3
+#define JSON_COMPRESS_MAX_MATCH 18
+
+// a pointer to a function that can send a single byte
+typedef void (*byte_sink_t)(char);
+
+typedef struct {
+    byte_sink_t sink;
+
+    // history and lookahead share a ring, so indexes wrap around for free
+    char ring[256];
+    uint8_t head;      // the first byte that hasn't been compressed yet
+    uint8_t lookahead; // the number of bytes waiting to be compressed
+    uint8_t history;   // the number of bytes available to match against
+
+    // bit packing
+    uint8_t bits;
+    uint8_t numBits;
+
+    // statistics
+    uint16_t bytesIn;
+    uint16_t bytesOut;
+} json_compressor_t;
+
+/* ************************************************************************** */
+
+// prepare to compress a stream that will be sent to 'sink'
+extern void json_compress_begin(json_compressor_t *compressor, byte_sink_t sink);
+
+// add some more text to the stream
+extern void json_compress_write(json_compressor_t *compressor,
+                                const char *string);
+
+// compress whatever is left, and terminate the stream
+extern void json_compress_end(json_compressor_t *compressor);
+
+/* -------------------------------------------------------------------------- */
+
+/*  json_print_compressed() prints a node list as a single compressed stream.
+
+    The compressor is a local, so it only needs RAM while the stream is being
+    printed. It's not safe to call this from inside an nFunction callback
+    that's being compressed.
+*/
+extern void json_print_compressed(byte_sink_t sink,
+                                  const json_node_t *nodeList);
+
+#endif // _JSON_COMPRESS_H_
@@ -0,0 +1,92 @@
+#include "json_decompress.h"
+#include <stddef.h>
+#include <stdint.h>
+
+/* ************************************************************************** */
+
+// these must match json_compress.c
+#define DISTANCE_BITS 7
+#define LENGTH_BITS 4
+#define MIN_MATCH 3
+
+typedef struct {
+    const uint8_t *input;
+    size_t inputLength;
+    size_t position; // in bits
+} bit_reader_t;
+
+// read 'count' bits, MSB first, returns -1 if the input ran out
+static int get_bits(bit_reader_t *reader, uint8_t count) {
+    int value = 0;
+
+    while (count--) {
+        size_t byte = reader->position / 8;
+        if (byte >= reader->inputLength) {
+            return -1;
+        }
+
+        uint8_t bit = 7 - (reader->position % 8);
+        value = (value << 1) | ((reader->input[byte] >> bit) & 1);
+        reader->position++;
+    }
+
+    return value;
+}
+
+/* ************************************************************************** */
+
+long json_decompress(const uint8_t *input, size_t inputLength, char *output,
+                     size_t outputSize, size_t *consumed) {
+    bit_reader_t reader = {input, inputLength, 0};
+    size_t length = 0;
+
+    while (1) {
+        int flag = get_bits(&reader, 1);
+        if (flag < 0) {
+            return -1;
+        }
+
+        if (flag == 0) {
+            int c = get_bits(&reader, 8);
+            if (c < 0 || length + 1 >= outputSize) {
+                return -1;
+            }
+            output[length++] = (char)c;
+            continue;
+        }
+
+        int distance = get_bits(&reader, DISTANCE_BITS);
+        if (distance < 0) {
+            return -1;
+        }
+
+        // a distance of zero is the end marker
+        if (distance == 0) {
+            break;
+        }
+
+        int matchLength = get_bits(&reader, LENGTH_BITS);
+        if (matchLength < 0) {
+            return -1;
+        }
+        matchLength += MIN_MATCH;
+
+        if ((size_t)distance > length ||
+            length + matchLength >= outputSize) {
+            return -1;
+        }
+
+        // byte by byte, because the source is allowed to overlap the output
+        for (int i = 0; i < matchLength; i++) {
+            output[length] = output[length - distance];
+            length++;
+        }
+    }
+
+    output[length] = '\0';
+
+    if (consumed) {
+        *consumed = (reader.position + 7) / 8;
+    }
+    return (long)length;
+}
@@ -0,0 +1,26 @@
+#ifndef _JSON_DECOMPRESS_H_
+#define _JSON_DECOMPRESS_H_
+
+/* ************************************************************************** */
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* ************************************************************************** */
+/*  Decoder for the streams produced by json_compress.c
+
+    This file is meant for the host side of the link. It doesn't depend on
+    anything else in this repository, and it's plain C99, so it can be dropped
+    into a host tool or wrapped by a scripting language's FFI.
+
+    'input' should start at the first byte of the compressed stream, and the
+    decoded text is written to 'output' and null terminated.
+
+    Returns the length of the decoded text, or -1 if the stream is corrupt,
+    truncated, or doesn't fit in 'output'. On success, 'consumed' is set to the
+    number of input bytes that made up the stream.
+*/
+extern long json_decompress(const uint8_t *input, size_t inputLength,
+                            char *output, size_t outputSize, size_t *consumed);
+
+#endif // _JSON_DECOMPRESS_H_
@@ -0,0 +1,328 @@
+#include "json_delta.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+/* ************************************************************************** */
+/*  The delta printer doesn't walk the node list itself. Handling nested node
+    lists, nFunction nodes, and the automatic closing braces is hard enough in
+    json_print.c, and there's no reason to do it twice.
+
+    Instead, the node list is printed normally by json_print(), but the output
+    is sent to filter_string() instead of the real destination. The filter
+    reads the JSON one character at a time and splits the top level object
+    into its key:value pairs. Each pair is collected into 'pair' while its
+    fingerprint is calculated, and once the pair is complete, it's either sent
+    to the real destination or thrown away.
+
+    JUDI messages keep everything interesting one level down, like
+    {"update":{...}}, so a top level pair whose value is an object is treated
+    as a container instead of a single pair. Its key and opening brace are
+    held at the start of 'pair' as a prefix, and each member of the object is
+    fingerprinted on its own, with the container's key mixed into the hash.
+    The prefix is only sent in front of the first member that changed, and if
+    nothing in the container changed, the whole container is left out.
+
+    All of the state of a print that's in progress lives in a filter_t, which
+    is a local in json_delta_print() and is passed to everything else. The
+    printer_t interface doesn't have room for any context, so filter_string()
+    finds it through 'current', which json_delta_print() saves and restores.
+    That makes it safe to print one delta from inside an nFunction callback of
+    another.
+*/
+
+typedef struct {
+    printer_t destination;
+    json_delta_t *delta;
+
+    // JSON structure tracking
+    uint8_t depth;
+    unsigned inString : 1;
+    unsigned escaped : 1;
+    unsigned inValue : 1;
+
+    // the pair currently being collected
+    char pair[JSON_DELTA_BUFFER_SIZE];
+    uint8_t length;
+    uint8_t keyLength; // where the key ends and the value starts
+    uint16_t keyHash;
+    uint16_t hash;
+    unsigned passthrough : 1; // the pair was too long and is being sent as-is
+
+    // the container whose members are currently being collected
+    uint8_t prefixLength; // its unsent key and brace, at the start of 'pair'
+    uint16_t containerHash;
+    unsigned inContainer : 1;
+    unsigned containerOpened : 1; // the prefix has been sent
+    unsigned sentMember : 1;
+
+    // output tracking
+    unsigned keyframe : 1;
+    unsigned opened : 1; // the opening brace has been sent
+    unsigned sentPair : 1;
+} filter_t;
+
+static filter_t *current = NULL;
+
+/* -------------------------------------------------------------------------- */
+
+static uint16_t hash_char(uint16_t hash, char c) {
+    return (hash << 5) + hash + (uint8_t)c; //
+}
+
+// send the collected characters, plus any punctuation that has to come first
+static void flush_pair(filter_t *filter) {
+    if (!filter->passthrough) {
+        if (!filter->opened) {
+            filter->destination("{");
+            filter->opened = true;
+        }
+
+        if (filter->inContainer && filter->containerOpened) {
+            // another member of a container that's already been started
+            if (filter->sentMember) {
+                filter->destination(",");
+            }
+        } else {
+            // a top level pair, or the first member to go out with its prefix
+            if (filter->sentPair) {
+                filter->destination(",");
+            }
+            filter->sentPair = true;
+        }
+
+        if (filter->inContainer) {
+            filter->containerOpened = true;
+            filter->sentMember = true;
+        }
+    }
+
+    filter->pair[filter->length] = '\0';
+    filter->destination(filter->pair);
+    filter->length = 0;
+
+    // the prefix went out with this pair
+    filter->prefixLength = 0;
+}
+
+static void start_pair(filter_t *filter) {
+    // a container's unsent prefix stays at the start of the buffer
+    filter->length = filter->prefixLength;
+    filter->hash = filter->inContainer ? filter->containerHash : 5381;
+    filter->keyHash = 0;
+    filter->keyLength = 0;
+    filter->inValue = false;
+    filter->passthrough = false;
+}
+
+static void append(filter_t *filter, char c) {
+    filter->hash = hash_char(filter->hash, c);
+
+    // leave room for the null terminator
+    if (filter->length >= JSON_DELTA_BUFFER_SIZE - 1) {
+        // this pair is too big to hold onto, so it's going to be sent no
+        // matter what its fingerprint says
+        flush_pair(filter);
+        filter->passthrough = true;
+    }
+
+    filter->pair[filter->length++] = c;
+}
+
+/* -------------------------------------------------------------------------- */
+
+// find the slot that belongs to this key, or make one
+static json_delta_slot_t *find_slot(filter_t *filter, uint16_t key) {
+    json_delta_t *delta = filter->delta;
+
+    for (uint8_t i = 0; i < delta->numPairs; i++) {
+        if (delta->slots[i].key == key) {
+            return &delta->slots[i];
+        }
+    }
+
+    if (delta->numPairs < delta->maxPairs) {
+        json_delta_slot_t *slot = &delta->slots[delta->numPairs++];
+        slot->key = key;
+        slot->value = ~filter->hash; // guaranteed to be different
+        return slot;
+    }
+
+    return NULL;
+}
+
+static void finish_pair(filter_t *filter) {
+    // an empty object, or something that isn't a key:value pair
+    if (filter->length == filter->prefixLength && !filter->passthrough) {
+        return;
+    }
+
+    json_delta_slot_t *slot = find_slot(filter, filter->keyHash);
+
+    bool changed = true;
+    if (slot) {
+        changed = (slot->value != filter->hash);
+        slot->value = filter->hash;
+    }
+
+    if (changed || filter->keyframe || filter->passthrough) {
+        flush_pair(filter);
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+
+// the top level pair that was just collected turns out to be a container
+static void open_container(filter_t *filter) {
+    append(filter, '{');
+
+    filter->inContainer = true;
+    filter->containerOpened = false;
+    filter->sentMember = false;
+    filter->containerHash = filter->keyHash;
+    filter->prefixLength = filter->length;
+    filter->depth = 2;
+
+    start_pair(filter);
+}
+
+static void close_container(filter_t *filter) {
+    finish_pair(filter);
+
+    if (filter->containerOpened) {
+        filter->destination("}");
+    } else if (filter->keyframe) {
+        // a keyframe sends everything, even an empty container
+        filter->length = filter->prefixLength;
+        filter->inContainer = false;
+        append(filter, '}');
+        flush_pair(filter);
+    }
+
+    filter->inContainer = false;
+    filter->prefixLength = 0;
+    filter->depth = 1;
+
+    // the container was the whole pair, there's nothing left to finish
+    start_pair(filter);
+}
+
+/* -------------------------------------------------------------------------- */
+
+static void filter_char(filter_t *filter, char c) {
+    // skip everything until the top level object starts
+    if (filter->depth == 0) {
+        if (c == '{') {
+            filter->depth = 1;
+            start_pair(filter);
+        }
+        return;
+    }
+
+    if (filter->inString) {
+        if (filter->escaped) {
+            filter->escaped = false;
+        } else if (c == '\\') {
+            filter->escaped = true;
+        } else if (c == '"') {
+            filter->inString = false;
+        }
+        append(filter, c);
+        return;
+    }
+
+    // the depth where the pairs that are being fingerprinted live
+    uint8_t pairDepth = filter->inContainer ? 2 : 1;
+
+    switch (c) {
+    case '"':
+        filter->inString = true;
+        break;
+    case '{':
+        // a top level value that's an object, with room left for its brace
+        if (filter->depth == 1 && filter->inValue && !filter->passthrough &&
+            filter->length == filter->keyLength &&
+            filter->length < JSON_DELTA_BUFFER_SIZE - 1) {
+            open_container(filter);
+            return;
+        }
+        filter->depth++;
+        break;
+    case '[':
+        filter->depth++;
+        break;
+    case '}':
+    case ']':
+        if (filter->depth == pairDepth) {
+            if (filter->inContainer) {
+                close_container(filter);
+                return;
+            }
+            // the end of the top level object
+            finish_pair(filter);
+            filter->depth = 0;
+            return;
+        }
+        filter->depth--;
+        break;
+    case ',':
+        if (filter->depth == pairDepth) {
+            finish_pair(filter);
+            start_pair(filter);
+            return;
+        }
+        break;
+    case ':':
+        if (filter->depth == pairDepth && !filter->inValue) {
+            // everything up to here was the key
+            append(filter, c);
+            filter->keyHash = filter->hash;
+            filter->keyLength = filter->length;
+            filter->inValue = true;
+            return;
+        }
+        break;
+    }
+
+    append(filter, c);
+}
+
+static void filter_string(const char *string) {
+    while (*string) {
+        filter_char(current, *string++);
+    }
+}
+
+/* ************************************************************************** */
+
+bool json_delta_print(printer_t destination, json_delta_t *delta) {
+    filter_t filter;
+    filter_t *previous = current;
+
+    memset(&filter, 0, sizeof(filter_t));
+    filter.destination = destination;
+    filter.delta = delta;
+
+    // the first message is always a keyframe, because every slot is new
+    if (delta->keyframeInterval) {
+        filter.keyframe = (delta->sinceKeyframe == 0);
+        if (++delta->sinceKeyframe >= delta->keyframeInterval) {
+            delta->sinceKeyframe = 0;
+        }
+    }
+
+    current = &filter;
+    json_print(filter_string, delta->nodeList);
+    current = previous;
+
+    if (filter.opened) {
+        destination("}");
+        return true;
+    }
+    return false;
+}
+
+void json_delta_reset(json_delta_t *delta) {
+    delta->numPairs = 0;
+    delta->sinceKeyframe = 0;
+}
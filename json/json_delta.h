@@ -0,0 +1,102 @@
+#ifndef _JSON_DELTA_H_
+#define _JSON_DELTA_H_
+
+/* ************************************************************************** */
+
+#include "json_node.h"
+#include "json_print.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+/* ************************************************************************** */
+/*  Delta-only JSON printing
+
+    Periodic status messages usually re-send every field even though only one
+    or two of them have changed since last time. json_delta_print() prints the
+    same node list json_print() would, but it leaves out any key:value pair
+    whose value hasn't changed since the last time it was sent.
+
+    JUDI messages wrap their contents in an object, like {"update":{...}}, so
+    the pairs that are compared are the top level pairs and the members of
+    any top level object. Objects nested deeper than that are treated as a
+    single value. A top level object that has no changed members is left out
+    entirely.
+
+    Example:
+        json_print() every time:
+            {"update":{"time":1000,"mode":"auto","info":{"name":"Bill"}}}
+            {"update":{"time":1500,"mode":"auto","info":{"name":"Bill"}}}
+            {"update":{"time":1500,"mode":"auto","info":{"name":"Bob"}}}
+
+        json_delta_print() every time:
+            {"update":{"time":1000,"mode":"auto","info":{"name":"Bill"}}}
+            {"update":{"time":1500}}
+            {"update":{"info":{"name":"Bob"}}}
+
+    Every 'KEYFRAME_INTERVAL' calls, the whole object is sent regardless, so a
+    host that missed something or connected late will catch up eventually.
+    The keyframe interval is also the longest a fingerprint collision can hide
+    a change, see below.
+
+    Instead of keeping a copy of every value, each pair is remembered by a
+    small fingerprint: a hash of its key and a hash of its printed value.
+    Values are hashed after they've been formatted, so every node type
+    works the same way and the existing node lists don't need to be modified.
+    The key of a member is hashed together with the key of the object it's
+    in, so "time" in "update" and "time" in "response" get separate slots.
+
+    The value hash is only 16 bits, so about one change in 65536 produces the
+    same fingerprint as the value it replaced, and isn't sent. Storing the
+    values themselves would take JSON_DELTA_BUFFER_SIZE bytes per pair instead
+    of 4, so instead, the next keyframe sends the right value. Pick the
+    keyframe interval with that in mind: it's how many messages a host might
+    show a stale value for, in the rare case that it happens at all.
+
+    Pairs are matched up by key, not by position, so pairs that come and go,
+    like the message_id, don't confuse anything. A pair whose printed value
+    doesn't fit in JSON_DELTA_BUFFER_SIZE is always sent.
+
+    The state of a print in progress is kept on the stack, so a delta can be
+    printed from inside an nFunction callback of another one.
+*/
+
+// the longest key:value pair that can be left out if it hasn't changed
+#define JSON_DELTA_BUFFER_SIZE 48
+
+typedef struct {
+    uint16_t key;
+    uint16_t value;
+} json_delta_slot_t;
+
+typedef struct {
+    const json_node_t *nodeList;
+    json_delta_slot_t *slots;
+    uint8_t maxPairs;
+    uint8_t keyframeInterval; // 0 means only the first message is a keyframe
+    uint8_t numPairs;
+    uint8_t sinceKeyframe;
+} json_delta_t;
+
+/*  JSON_DELTA() declares a delta printer and the storage it needs
+
+    MAX_PAIRS is the number of key:value pairs to remember, counting the
+    members of top level objects but not the objects themselves. Pairs that
+    don't get a slot are always sent. KEYFRAME_INTERVAL bounds how long a
+    fingerprint collision can hide a change, see above.
+
+    Example:
+    JSON_DELTA(statusDelta, statusMessage, 8, 20);
+*/
+#define JSON_DELTA(NAME, NODE_LIST, MAX_PAIRS, KEYFRAME_INTERVAL)              \
+    static json_delta_slot_t NAME##_slots[MAX_PAIRS];                          \
+    json_delta_t NAME = {NODE_LIST, NAME##_slots, MAX_PAIRS, KEYFRAME_INTERVAL}
+
+/* ************************************************************************** */
+
+// print only the pairs that changed, returns false if nothing was printed
+extern bool json_delta_print(printer_t destination, json_delta_t *delta);
+
+// forget everything, so the next call sends the whole object
+extern void json_delta_reset(json_delta_t *delta);
+
+#endif // _JSON_DELTA_H_
@@ -0,0 +1,44 @@
+#include "json_memo.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* ************************************************************************** */
+
+static void render(json_memo_t *memo) {
+    json_printer_t printer;
+    json_printer_init_buffer(&printer, memo->buffer, memo->bufferSize);
+
+    json_printer_print(&printer, memo->nodeList);
+
+    memo->failed = printer.overflow;
+    memo->rendered = true;
+}
+
+/* -------------------------------------------------------------------------- */
+
+const char *json_memo_get(json_memo_t *memo) {
+    if (!memo->rendered) {
+        render(memo);
+    }
+
+    if (memo->failed) {
+        return NULL;
+    }
+    return memo->buffer;
+}
+
+void json_memo_print(printer_t destination, json_memo_t *memo) {
+    const char *string = json_memo_get(memo);
+
+    if (string) {
+        destination(string);
+    } else {
+        // the buffer is too small, so do it the slow way
+        json_print(destination, memo->nodeList);
+    }
+}
+
+void json_memo_invalidate(json_memo_t *memo) {
+    memo->rendered = false; //
+}
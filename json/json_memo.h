@@ -0,0 +1,59 @@
+#ifndef _JSON_MEMO_H_
+#define _JSON_MEMO_H_
+
+/* ************************************************************************** */
+
+#include "json_node.h"
+#include "json_print.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+/* ************************************************************************** */
+/*  Memoized JSON
+
+    Some node lists never change after the system boots: the device info,
+    serial number, compilation info, and so on. Printing them with json_print()
+    means walking the node list and running sprintf() on every value, every
+    single time somebody asks for them.
+
+    A memo renders its node list into a RAM buffer the first time it's
+    printed, and every print after that is a single write of the buffer.
+
+    Only use this for node lists that are truly immutable once the first print
+    has happened! nFunction nodes are evaluated once, during the first print,
+    and never again.
+
+    If the rendered node list doesn't fit in the buffer, the memo falls back to
+    printing the node list with json_print() every time.
+
+    Example:
+    JSON_MEMO(deviceInfoMemo, deviceInfo, 128);
+
+    json_memo_print(usb_print, &deviceInfoMemo);
+*/
+
+typedef struct {
+    const json_node_t *nodeList;
+    char *buffer;
+    uint16_t bufferSize;
+    unsigned rendered : 1;
+    unsigned failed : 1;
+} json_memo_t;
+
+// declare a memo and the buffer it renders into
+#define JSON_MEMO(NAME, NODE_LIST, BUFFER_SIZE)                                \
+    static char NAME##_buffer[BUFFER_SIZE];                                    \
+    json_memo_t NAME = {NODE_LIST, NAME##_buffer, BUFFER_SIZE}
+
+/* ************************************************************************** */
+
+// print the memo, rendering it first if necessary
+extern void json_memo_print(printer_t destination, json_memo_t *memo);
+
+// get the rendered string, or NULL if it doesn't fit in the buffer
+extern const char *json_memo_get(json_memo_t *memo);
+
+// throw away the rendered string, so it's rendered again on the next print
+extern void json_memo_invalidate(json_memo_t *memo);
+
+#endif // _JSON_MEMO_H_
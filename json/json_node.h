@@ -42,6 +42,7 @@ typedef struct {
 } json_node_t;
 
 // A pointer to a function that returns a pointer to an array of json_node_t
+// Functions with side effects can check json_printer_is_measuring()
 const typedef json_node_t *(*node_function_ptr_t)(void);
 
 // A struct containing ^^^
@@ -2,25 +2,51 @@
 #include <stdbool.h>
 #include <stdint.h>
 #include <stdio.h>
+#include <string.h>
 
 /* ************************************************************************** */
 
-/*  This is a pointer to the printer function that was passed as the first
-    argument to json_print(). This could have been passed down the call tree as
-    an argument, and some people probably would have preferred that, but since
-    evaluate_node_list() can end up being called recursively AND the value of
-    out can't change in the middle of that, I think it makes more sense to pull
-    this out to file scope to help limit stack growth.
+/*  All of the state needed to print a JSON object lives in a json_printer_t.
+    An earlier version of this file kept the printer function and the brace
+    tracking variables at file scope, to avoid passing them down the call tree
+    through every recursive call to evaluate_node_list().
 
-    typedef void (*printer_t)(const char *);
+    That made it impossible to print two things at once. An nFunction callback
+    that printed something of its own, or a response being rendered into RAM
+    while another one was being printed, would trample the state of whatever
+    was already in progress. Passing a single pointer down the stack is a small
+    price to pay for not having to worry about that.
 
+    typedef void (*printer_t)(const char *);
 */
 
-static void dummy_print(const char *string) {
-    // this body left intentionally blank
+// send a string to wherever this printer is pointed
+void json_printer_write(json_printer_t *printer, const char *string) {
+    if (printer->out) {
+        printer->out(string);
+        return;
+    }
+
+    // no destination at all, so we're only counting
+    if (!printer->buffer) {
+        printer->length += strlen(string);
+        return;
+    }
+
+    // no printer function, so append the string to the RAM buffer instead
+    while (*string) {
+        // leave room for the null terminator
+        if (printer->length + 1 >= printer->bufferSize) {
+            printer->overflow = true;
+            return;
+        }
+        printer->buffer[printer->length++] = *string++;
+    }
+    printer->buffer[printer->length] = '\0';
 }
 
-static printer_t out = &dummy_print;
+// shortcut for the functions below, which all have a 'printer' in scope
+#define out(string) json_printer_write(printer, string)
 
 /* ************************************************************************** */
 
@@ -28,7 +54,7 @@ static printer_t out = &dummy_print;
     inside string literals have to be escaped, we'll provide a function that
     does it for you.
 */
-static void print_json_string(char *string) {
+static void print_json_string(json_printer_t *printer, char *string) {
     out("\"");
     out(string);
     out("\"");
@@ -36,7 +62,45 @@ static void print_json_string(char *string) {
 
 /* -------------------------------------------------------------------------- */
 
-static void evaluate_node_list(const json_node_t *nodeList); // forward dec
+/*  Any number(or null) node is formatted here.
+
+    The conversion to string is done using sprintf instead of printf(), because
+    printf() has a fixed destination of whatever putc() goes. Since the output
+    of json_print() is retargetable, we format with sprintf(), put the result in
+    a char buffer, and then the caller can send that char buffer to wherever
+    the json_printer_t is pointed.
+
+    The buffer must be at least JSON_VALUE_BUFFER_SIZE bytes long.
+*/
+uint8_t json_format_value(char *buffer, const json_node_t *node) {
+    switch (node->type) {
+    case nFloat:
+        return sprintf(buffer, "%f", *(double *)node->contents);
+    case nFloat_p2:
+        return sprintf(buffer, "%.2f", *(double *)node->contents);
+    case nU8:
+        return sprintf(buffer, "%u", *(uint8_t *)node->contents);
+    case nU16:
+        return sprintf(buffer, "%u", *(uint16_t *)node->contents);
+    case nU32:
+        return sprintf(buffer, "%lu",
+                       (unsigned long)*(uint32_t *)node->contents);
+    case nS8:
+        return sprintf(buffer, "%d", *(int8_t *)node->contents);
+    case nS16:
+        return sprintf(buffer, "%d", *(int16_t *)node->contents);
+    case nS32:
+        return sprintf(buffer, "%ld", (long)*(int32_t *)node->contents);
+    case nNull:
+    default: // type not supported
+        return sprintf(buffer, "null");
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+
+static void evaluate_node_list(json_printer_t *printer,
+                               const json_node_t *nodeList); // forward dec
 
 /*  Any non-control node is evaluated here.
 
@@ -45,77 +109,46 @@ static void evaluate_node_list(const json_node_t *nodeList); // forward dec
     Evaluating a node involves looking at the type of that node, performing the
     relevant typecast on the contents pointer, converting those contents into a
     string, and then printing it.
-
-    The conversion to string is done using sprintf instead of printf(), because
-    printf() has a fixed destination of whatever putc() goes. Since the output
-    of json_print() is retargetable, we format with sprintf(), but the result in
-    a local char buffer, and then print that char buffer using the function
-    pointer that was given to json_print() and copied into 'out'.
 */
 
-// we need to stash this to properly handle commas later
-static const json_node_t *funcNodeResult = NULL;
-
-static bool evaluate_node(const json_node_t *node) {
-    char buffer[50] = {0};
+static bool evaluate_node(json_printer_t *printer, const json_node_t *node) {
+    char buffer[JSON_VALUE_BUFFER_SIZE] = {0};
 
     switch (node->type) {
     case nNodeList:
-        evaluate_node_list((const json_node_t *)node->contents);
+        evaluate_node_list(printer, (const json_node_t *)node->contents);
         return true;
     case nFunction:
-        // an nFunction node is actually evaluated in the comma handling section
-        // of evaluate_node_list()
-        if (funcNodeResult) {
-            evaluate_node_list(funcNodeResult);
+        // an nFunction node is usually evaluated in the comma handling section
+        // of evaluate_node_list(), but if the node before it wasn't a value,
+        // nobody looked ahead and we have to call the function ourselves
+        if (printer->funcNode != node) {
+            printer->funcNodeResult =
+                json_call_function(node->contents, printer->measuring);
+        }
+        printer->funcNode = NULL;
+
+        if (printer->funcNodeResult) {
+            evaluate_node_list(printer, printer->funcNodeResult);
             return true;
         }
         return false;
     case nKey:
-        print_json_string((char *)node->contents);
+        print_json_string(printer, (char *)node->contents);
         out(":");
         return true;
     case nString:
-        print_json_string((char *)node->contents);
-        return true;
-    case nFloat:
-        sprintf(&buffer[0], "%f", *(double *)node->contents);
-        out(buffer);
+        print_json_string(printer, (char *)node->contents);
         return true;
-    case nFloat_p2:
-        sprintf(&buffer[0], "%.2f", *(double *)node->contents);
-        out(buffer);
-        return true;
-    case nU8:
-        sprintf(&buffer[0], "%u", *(uint8_t *)node->contents);
-        out(buffer);
-        return true;
-    case nU16:
-        sprintf(&buffer[0], "%u", *(uint16_t *)node->contents);
-        out(buffer);
-        return true;
-    case nU32:
-        sprintf(&buffer[0], "%lu", *(uint32_t *)node->contents);
-        out(buffer);
-        return true;
-    case nS8:
-        sprintf(&buffer[0], "%d", *(int8_t *)node->contents);
-        out(buffer);
-        return true;
-    case nS16:
-        sprintf(&buffer[0], "%d", *(int16_t *)node->contents);
-        out(buffer);
-        return true;
-    case nS32:
-        sprintf(&buffer[0], "%ld", *(int32_t *)node->contents);
+    default:
+        if (!printer->out && !printer->buffer) {
+            // counting, and we already know how long the formatted value is
+            printer->length += json_format_value(&buffer[0], node);
+            return true;
+        }
+        json_format_value(&buffer[0], node);
         out(buffer);
         return true;
-    case nNull:
-        out("null");
-        return true;
-    default: // type not supported
-        out("null");
-        return true;
     }
 }
 
@@ -141,7 +174,6 @@ static bool evaluate_node(const json_node_t *node) {
         before returning, we'll print close braces until we've balanced all the
         open braces.
 */
-static uint8_t braceDepth = 0;
 
 /*  recursionCount:
 
@@ -171,7 +203,6 @@ static uint8_t braceDepth = 0;
     Now, we can control the previously described brace matching feature and only
     do it when we're at the end of the starting(parent) node list.
 */
-static uint8_t recursionCount = 0;
 
 /*  evaluate_node_list() builds a JSON string by iterating through an array of
     json_node_t's.
@@ -193,11 +224,12 @@ static uint8_t recursionCount = 0;
     triggers a RESET. It's your responsibility to make sure your JSON node lists
     aren't dangerous.
 */
-static void evaluate_node_list(const json_node_t *list) {
+static void evaluate_node_list(json_printer_t *printer,
+                               const json_node_t *list) {
     const json_node_t *currentNode;
     const json_node_t *nextNode;
 
-    recursionCount++;
+    printer->recursionCount++;
 
     while (1) {
         currentNode = list;
@@ -207,13 +239,13 @@ static void evaluate_node_list(const json_node_t *list) {
             char controlChar = ((const char *)currentNode->contents)[0];
             switch (controlChar) {
             case '{':
-                braceDepth++;
+                printer->braceDepth++;
                 out("{");
                 break;
             case '}':
-                braceDepth--;
+                printer->braceDepth--;
                 out("}");
-                if (braceDepth == 0) {
+                if (printer->braceDepth == 0) {
                     return;
                 }
                 if (nextNode->type != nControl) {
@@ -221,16 +253,16 @@ static void evaluate_node_list(const json_node_t *list) {
                 }
                 break;
             case '\e':
-                recursionCount--;
-                if (recursionCount == 0) {
-                    while (braceDepth--) {
+                printer->recursionCount--;
+                if (printer->recursionCount == 0) {
+                    while (printer->braceDepth--) {
                         out("}");
                     }
                 }
                 return;
             }
         } else {
-            if (!evaluate_node(currentNode)) {
+            if (!evaluate_node(printer, currentNode)) {
                 continue;
             }
 
@@ -243,9 +275,11 @@ static void evaluate_node_list(const json_node_t *list) {
                     out(",");
                 }
             } else if (nextNode->type == nFunction) {
-                funcNodeResult = ((const node_function_t *)nextNode->contents)->ptr();
-                if (funcNodeResult) {
-                    if (funcNodeResult->type == nKey) {
+                printer->funcNode = nextNode;
+                printer->funcNodeResult =
+                    json_call_function(nextNode->contents, printer->measuring);
+                if (printer->funcNodeResult) {
+                    if (printer->funcNodeResult->type == nKey) {
                         out(",");
                     }
                 }
@@ -256,22 +290,120 @@ static void evaluate_node_list(const json_node_t *list) {
 
 /* -------------------------------------------------------------------------- */
 
+void json_printer_init(json_printer_t *printer, printer_t destination) {
+    memset(printer, 0, sizeof(json_printer_t));
+
+    printer->out = destination;
+}
+
+void json_printer_init_buffer(json_printer_t *printer, char *buffer,
+                              uint16_t bufferSize) {
+    memset(printer, 0, sizeof(json_printer_t));
+
+    printer->buffer = buffer;
+    printer->bufferSize = bufferSize;
+    printer->buffer[0] = '\0';
+}
+
+/* -------------------------------------------------------------------------- */
+
 /*  A JSON object is printed by stepping through its definition one node at a
     time until we're done. Each node is evaluated one by one and its contents
-    converted to a string and passed to the printing function defined as
-    'destination'.
+    converted to a string and passed to the printer's destination.
 */
-void json_print(printer_t destination, const json_node_t *nodeList) {
-    // copy the destination pointer to a static variable, so we don't have to
-    // keep passing it down the stack
-    out = destination;
-
+void json_printer_print(json_printer_t *printer, const json_node_t *nodeList) {
     // Reset the internal state used to keep track of the JSON structure
-    braceDepth = 0;
-    recursionCount = 0;
+    printer->braceDepth = 0;
+    printer->recursionCount = 0;
+    printer->funcNode = NULL;
+    printer->funcNodeResult = NULL;
 
     //
-    evaluate_node_list(nodeList);
+    evaluate_node_list(printer, nodeList);
+}
+
+/*  json_printer_print_value() prints a single value node exactly the same way
+    it would be printed as part of a node list, with no punctuation around it.
+*/
+void json_printer_print_value(json_printer_t *printer,
+                              const json_node_t *node) {
+    evaluate_node(printer, node);
+}
+
+/*  json_printer_print_fragment() prints a node list that's meant to be included
+    in the middle of a larger JSON object, like the result of an nFunction node.
+
+    Setting recursionCount to 1 makes evaluate_node_list() think it's already
+    inside a parent list, so hitting the "\e" at the end of the fragment won't
+    produce any closing braces.
+*/
+void json_printer_print_fragment(json_printer_t *printer,
+                                 const json_node_t *nodeList) {
+    printer->braceDepth = 0;
+    printer->recursionCount = 1;
+    printer->funcNode = NULL;
+    printer->funcNodeResult = NULL;
+
+    evaluate_node_list(printer, nodeList);
+}
+
+/* -------------------------------------------------------------------------- */
+
+/*  json_print() is a shortcut for printing a whole object to a printer_t. The
+    json_printer_t lives on the stack, so json_print() can be safely called
+    again from inside an nFunction callback.
+*/
+void json_print(printer_t destination, const json_node_t *nodeList) {
+    json_printer_t printer;
+    json_printer_init(&printer, destination);
+
+    json_printer_print(&printer, nodeList);
+}
+
+/*  json_measure() runs the exact same evaluation as json_print(), but with a
+    printer that has no destination. Nothing gets formatted twice, constant
+    strings are only strlen()'d, and the result is exactly the number of bytes
+    json_print() would produce.
+
+    nFunction nodes are still called while measuring, because there's no other
+    way to know what they'll produce. The printer's 'measuring' flag is what
+    json_printer_is_measuring() reports during those calls, so functions that
+    have side effects, like get_message_id, can skip them. The flag belongs to
+    this printer alone, so a message that's being printed at the same time
+    isn't affected.
+
+    The result is only accurate if nothing changes between measuring and
+    printing. The values in the node list are live variables, so an interrupt
+    that updates one of them could make a number one digit longer.
+*/
+uint16_t json_measure(const json_node_t *nodeList) {
+    json_printer_t printer;
+    json_printer_init(&printer, NULL);
+    printer.measuring = true;
+
+    json_printer_print(&printer, nodeList);
+
+    return printer.length;
+}
+
+/* -------------------------------------------------------------------------- */
+
+// the measuring flag of whichever printer's nFunction is running right now
+static bool callerIsMeasuring = false;
+
+const json_node_t *json_call_function(const void *function, bool measuring) {
+    // callbacks can print too, so put back whatever was there before
+    bool previous = callerIsMeasuring;
+
+    callerIsMeasuring = measuring;
+    const json_node_t *result = ((const node_function_t *)function)->ptr();
+    callerIsMeasuring = previous;
+
+    return result;
+}
+
+bool json_printer_is_measuring(void) {
+    return callerIsMeasuring; //
 }
 
 /* ************************************************************************** */
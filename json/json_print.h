@@ -8,6 +8,8 @@
     own C representations for JSON objects.
 */
 #include "json_node.h"
+#include <stdbool.h>
+#include <stdint.h>
 
 /* ************************************************************************** */
 
@@ -21,6 +23,51 @@
 */
 typedef void (*printer_t)(const char *);
 
+/*  json_printer_t holds everything needed to print a JSON object: where the
+    output is going, and the state used to keep track of the structure of the
+    object being printed.
+
+    A printer can send its output to a printer_t function, or it can render the
+    output into a RAM buffer. A printer with neither only counts the bytes it
+    would have produced, which is how json_measure() works. Since all the state
+    lives in the printer, it's safe to have several printers working at the
+    same time, like printing one response while another is being rendered into
+    RAM, or printing from inside an nFunction callback.
+*/
+typedef struct {
+    printer_t out;
+
+    // RAM destination, used when 'out' is NULL
+    char *buffer;
+    uint16_t bufferSize;
+    uint16_t length; // also the byte count when there's no destination
+
+    // see json_print.c for more information
+    uint8_t braceDepth;
+    uint8_t recursionCount;
+    const json_node_t *funcNode;
+    const json_node_t *funcNodeResult;
+
+    unsigned overflow : 1;  // the RAM buffer was too small
+    unsigned measuring : 1; // see json_printer_is_measuring()
+} json_printer_t;
+
+// set up a printer that sends its output to 'destination'
+extern void json_printer_init(json_printer_t *printer, printer_t destination);
+
+// set up a printer that renders its output into a null-terminated RAM buffer
+extern void json_printer_init_buffer(json_printer_t *printer, char *buffer,
+                                     uint16_t bufferSize);
+
+// print a complete JSON object using the given printer
+extern void json_printer_print(json_printer_t *printer,
+                               const json_node_t *nodeList);
+
+// send a raw string to the printer's destination
+extern void json_printer_write(json_printer_t *printer, const char *string);
+
+/* -------------------------------------------------------------------------- */
+
 /*  json_print() creates a JSON object using 'nodeList' and prints it using the
     provided 'destination' function pointer. This allows json_print() to target 
     different serial ports if the system has them.
@@ -35,4 +82,52 @@ typedef void (*printer_t)(const char *);
 */
 extern void json_print(printer_t destination, const json_node_t *nodeList);
 
+/*  json_measure() returns the number of bytes json_print() would produce for
+    'nodeList', without printing anything. This is useful for length-prefixed
+    framing, or for checking whether there's enough TX buffer space to send a
+    response before starting it.
+
+    Example:
+    if (json_measure(bigResponse) <= serial_port_tx_space()) {
+        json_print(usb_print, bigResponse);
+    }
+*/
+extern uint16_t json_measure(const json_node_t *nodeList);
+
+/*  nFunction callbacks are still called while measuring, because there's no
+    other way to know what they'll produce. A callback with side effects, like
+    get_message_id, can call json_printer_is_measuring() to find out whether
+    the printer that called it is really sending anything.
+
+    Every printer calls nFunctions through json_call_function(), which sets
+    the answer for just that call, so it's right even when one printer runs
+    inside another printer's callback.
+*/
+extern bool json_printer_is_measuring(void);
+
+// call the node_function_t from an nFunction node's contents
+extern const json_node_t *json_call_function(const void *function,
+                                             bool measuring);
+
+/* -------------------------------------------------------------------------- */
+
+// the size of the buffer needed to hold any formatted value
+#define JSON_VALUE_BUFFER_SIZE 50
+
+// format the contents of a number or null node into 'buffer'
+// returns the length of the resulting string
+extern uint8_t json_format_value(char *buffer, const json_node_t *node);
+
+/*  These are the building blocks used by json_template.c, which handles all the
+    JSON punctuation itself and only needs help with the dynamic parts.
+*/
+
+// print the contents of a single value node, with no punctuation
+extern void json_printer_print_value(json_printer_t *printer,
+                                     const json_node_t *node);
+
+// print a node list without closing any braces when it ends
+extern void json_printer_print_fragment(json_printer_t *printer,
+                                        const json_node_t *nodeList);
+
 #endif // _JSON_PRINT_H_
\ No newline at end of file
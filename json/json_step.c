@@ -0,0 +1,213 @@
+#include "json_step.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+/* ************************************************************************** */
+/*  The step printer is split into two halves.
+
+    The first half, advance(), is a non-recursive copy of evaluate_node_list()
+    from json_print.c. Every time it's called, it evaluates exactly one node and
+    queues up the strings that node would have printed. See json_print.c for an
+    explanation of braceDepth and the comma rules, they're exactly the same.
+
+    The second half, json_print_step(), prints those queued strings while
+    keeping track of how many bytes it's allowed to print. If it runs out of
+    budget in the middle of a string, it remembers how far it got.
+*/
+
+static void queue(json_step_t *step, const char *string) {
+    if (step->numPieces >= JSON_STEP_MAX_PIECES) {
+        step->overflow = true;
+        return;
+    }
+
+    step->pieces[step->numPieces++] = string;
+}
+
+static void push_list(json_step_t *step, const json_node_t *list) {
+    if (step->depth >= JSON_STEP_MAX_DEPTH) {
+        step->overflow = true;
+        return;
+    }
+
+    step->stack[step->depth++] = list;
+}
+
+/* -------------------------------------------------------------------------- */
+
+// queue a comma if the node after a value needs one
+static void queue_comma_if_needed(json_step_t *step,
+                                  const json_node_t *nextNode) {
+    if (nextNode->type == nKey) {
+        queue(step, ",");
+    } else if (nextNode->type == nNodeList) {
+        const json_node_t *lookAhead = nextNode->contents;
+        if (lookAhead->type == nKey) {
+            queue(step, ",");
+        }
+    } else if (nextNode->type == nFunction) {
+        step->funcNode = nextNode;
+        step->funcNodeResult = json_call_function(nextNode->contents, false);
+        if (step->funcNodeResult) {
+            if (step->funcNodeResult->type == nKey) {
+                queue(step, ",");
+            }
+        }
+    }
+}
+
+// leave the current list and finish handling the node that included it
+static void pop_list(json_step_t *step) {
+    step->depth--;
+
+    if (step->depth == 0) {
+        step->done = true;
+        return;
+    }
+
+    // the parent list has already moved past the node that included us
+    queue_comma_if_needed(step, step->stack[step->depth - 1]);
+}
+
+/* -------------------------------------------------------------------------- */
+
+// evaluate the next node and queue whatever it's supposed to print
+static void advance(json_step_t *step) {
+    // once the top level list ends, all that's left is the closing braces
+    if (step->depth == 0) {
+        if (step->braceDepth) {
+            step->braceDepth--;
+            queue(step, "}");
+        } else {
+            step->done = true;
+        }
+        return;
+    }
+
+    const json_node_t *currentNode = step->stack[step->depth - 1];
+    const json_node_t *nextNode = ++step->stack[step->depth - 1];
+
+    switch (currentNode->type) {
+    case nControl:
+        switch (((const char *)currentNode->contents)[0]) {
+        case '{':
+            step->braceDepth++;
+            queue(step, "{");
+            return;
+        case '}':
+            step->braceDepth--;
+            queue(step, "}");
+            if (step->braceDepth == 0) {
+                pop_list(step);
+                return;
+            }
+            if (nextNode->type != nControl) {
+                queue(step, ",");
+            }
+            return;
+        case '\e':
+            if (step->depth == 1) {
+                // the top of advance() will queue the closing braces
+                step->depth = 0;
+            } else {
+                pop_list(step);
+            }
+            return;
+        }
+        return;
+    case nNodeList:
+        push_list(step, (const json_node_t *)currentNode->contents);
+        return;
+    case nFunction:
+        // an nFunction node is usually evaluated in the comma handling of the
+        // node before it, and does nothing if it produced nothing
+        if (step->funcNode != currentNode) {
+            step->funcNodeResult =
+                json_call_function(currentNode->contents, false);
+        }
+        step->funcNode = NULL;
+
+        if (step->funcNodeResult) {
+            push_list(step, step->funcNodeResult);
+        }
+        return;
+    case nKey:
+        queue(step, "\"");
+        queue(step, (const char *)currentNode->contents);
+        queue(step, "\":");
+        break;
+    case nString:
+        queue(step, "\"");
+        queue(step, (const char *)currentNode->contents);
+        queue(step, "\"");
+        break;
+    default:
+        json_format_value(&step->buffer[0], currentNode);
+        queue(step, &step->buffer[0]);
+        break;
+    }
+
+    queue_comma_if_needed(step, nextNode);
+}
+
+/* ************************************************************************** */
+
+void json_step_begin(json_step_t *step, printer_t destination,
+                     const json_node_t *nodeList) {
+    memset(step, 0, sizeof(json_step_t));
+
+    step->out = destination;
+    step->stack[0] = nodeList;
+    step->depth = 1;
+}
+
+bool json_step_is_done(json_step_t *step) {
+    return step->done && (step->currentPiece == step->numPieces);
+}
+
+bool json_print_step(json_step_t *step, uint16_t maxBytes) {
+    char chunk[JSON_STEP_CHUNK_SIZE + 1];
+
+    while (maxBytes) {
+        // refill the queue once everything in it has been printed
+        if (step->currentPiece == step->numPieces) {
+            if (step->done) {
+                break;
+            }
+            step->numPieces = 0;
+            step->currentPiece = 0;
+            step->offset = 0;
+            advance(step);
+            continue;
+        }
+
+        const char *piece = step->pieces[step->currentPiece] + step->offset;
+        size_t length = strlen(piece);
+
+        // the rest of this piece fits, so print it directly
+        if (length <= maxBytes) {
+            step->out(piece);
+            maxBytes -= length;
+            step->currentPiece++;
+            step->offset = 0;
+            continue;
+        }
+
+        // only part of it fits, so copy as much as we can and stop there
+        if (maxBytes > JSON_STEP_CHUNK_SIZE) {
+            length = JSON_STEP_CHUNK_SIZE;
+        } else {
+            length = maxBytes;
+        }
+        memcpy(chunk, piece, length);
+        chunk[length] = '\0';
+        step->out(chunk);
+
+        maxBytes -= length;
+        step->offset += length;
+    }
+
+    return json_step_is_done(step);
+}
@@ -0,0 +1,92 @@
+#ifndef _JSON_STEP_H_
+#define _JSON_STEP_H_
+
+/* ************************************************************************** */
+
+#include "json_node.h"
+#include "json_print.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+/* ************************************************************************** */
+/*  Resumable JSON printing
+
+    json_print() runs to completion, which means a large response can hold the
+    superloop hostage until the whole thing has been handed to the UART.
+
+    json_print_step() produces the exact same output as json_print(), but it
+    stops after emitting 'maxBytes' bytes and picks up where it left off the
+    next time it's called. The worst-case time spent in a single call is
+    bounded by 'maxBytes', no matter how big the JSON object is.
+
+    Instead of recursing through evaluate_node_list(), the step printer keeps
+    an explicit stack of the node lists it's currently inside of. The stack
+    depth is limited to JSON_STEP_MAX_DEPTH nested nNodeList or nFunction
+    nodes. A list that would overflow the stack is skipped, and the 'overflow'
+    flag is set.
+
+    Each node is turned into a short queue of strings, at most
+    JSON_STEP_MAX_PIECES of them. The longest is a key or a string followed by
+    a comma: the opening quote, the contents, the closing quote (and colon),
+    and the comma. A piece that doesn't fit in the queue is dropped, which
+    makes the output invalid JSON, so 'overflow' is set for that too. Check it
+    once the step printer is done.
+
+    Example:
+        static json_step_t step;
+
+        json_step_begin(&step, usb_print, deviceInfo);
+
+        // in the superloop
+        if (!json_step_is_done(&step)) {
+            json_print_step(&step, serial_port_tx_space());
+        }
+*/
+
+// maximum number of nested node lists
+#define JSON_STEP_MAX_DEPTH 6
+
+// maximum number of pieces a single node can produce
+#define JSON_STEP_MAX_PIECES 4
+
+// partial pieces are copied into a buffer this size before being printed
+#define JSON_STEP_CHUNK_SIZE 16
+
+typedef struct {
+    printer_t out;
+
+    // the next node to be evaluated in each list we're currently inside of
+    const json_node_t *stack[JSON_STEP_MAX_DEPTH];
+    uint8_t depth;
+    uint8_t braceDepth;
+
+    // stashed result of an nFunction node, needed for comma handling
+    const json_node_t *funcNode;
+    const json_node_t *funcNodeResult;
+
+    // the strings produced by the current node that still need printing
+    const char *pieces[JSON_STEP_MAX_PIECES];
+    uint8_t numPieces;
+    uint8_t currentPiece;
+    uint16_t offset;
+
+    // storage for formatted values
+    char buffer[JSON_VALUE_BUFFER_SIZE];
+
+    unsigned done : 1;
+    unsigned overflow : 1; // something was dropped, the output isn't valid
+} json_step_t;
+
+/* ************************************************************************** */
+
+// prepare to print 'nodeList' to 'destination'
+extern void json_step_begin(json_step_t *step, printer_t destination,
+                            const json_node_t *nodeList);
+
+// print at most 'maxBytes' bytes, returns true once the object is complete
+extern bool json_print_step(json_step_t *step, uint16_t maxBytes);
+
+// returns true once there's nothing left to print
+extern bool json_step_is_done(json_step_t *step);
+
+#endif // _JSON_STEP_H_
@@ -0,0 +1,276 @@
+#include "json_template.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* ************************************************************************** */
+/*  Template compiler
+
+    The compiler walks the node list the same way evaluate_node_list() does, but
+    instead of printing the constant parts, it collects them into the text pool.
+    Every time it reaches something that can't be known in advance, it closes
+    the current text segment and adds a hole to the operation list.
+
+    Commas are handled differently than in json_print.c. Instead of looking
+    ahead to see if the NEXT node is a key, the compiler remembers what it saw
+    LAST. A key that follows a complete key:value pair needs a comma in front of
+    it, and anything else doesn't.
+
+    This matters for nFunction nodes, because there's no way to know whether
+    they'll print anything until the template is actually printed. Keys that
+    follow a function get a tComma operation instead of a literal comma, and
+    the decision is made at print time.
+*/
+
+typedef enum {
+    sOpen,    // just opened an object, no comma needed yet
+    sMember,  // just finished a key:value pair
+    sKey,     // just printed a key, waiting for its value
+    sDynamic, // just evaluated an nFunction, we won't know until print time
+} compile_state_t;
+
+typedef struct {
+    json_template_t *template;
+    uint16_t textLength;
+    uint16_t segmentStart;
+    uint8_t braceDepth;
+    uint8_t recursionCount;
+    compile_state_t state;
+    bool done;
+} template_compiler_t;
+
+/* -------------------------------------------------------------------------- */
+
+static void add_op(template_compiler_t *compiler, uint8_t type, uint8_t flags,
+                   const void *contents) {
+    json_template_t *template = compiler->template;
+
+    if (template->numOps >= template->maxOps) {
+        template->failed = true;
+        return;
+    }
+
+    template->ops[template->numOps].type = type;
+    template->ops[template->numOps].flags = flags;
+    template->ops[template->numOps].contents = contents;
+    template->numOps++;
+}
+
+// add some constant text to the segment that's currently being assembled
+static void append_text(template_compiler_t *compiler, const char *string) {
+    json_template_t *template = compiler->template;
+
+    while (*string) {
+        // leave room for the segment's null terminator
+        if (compiler->textLength + 1 >= template->textSize) {
+            template->failed = true;
+            return;
+        }
+        template->text[compiler->textLength++] = *string++;
+    }
+}
+
+// terminate the current text segment and add it to the operation list
+static void close_segment(template_compiler_t *compiler) {
+    json_template_t *template = compiler->template;
+
+    if (compiler->textLength == compiler->segmentStart) {
+        return;
+    }
+
+    template->text[compiler->textLength++] = '\0';
+    add_op(compiler, tSegment, 0, &template->text[compiler->segmentStart]);
+    compiler->segmentStart = compiler->textLength;
+}
+
+/* -------------------------------------------------------------------------- */
+
+static void compile_key(template_compiler_t *compiler, const char *key) {
+    if (compiler->state == sMember) {
+        append_text(compiler, ",");
+    } else if (compiler->state == sDynamic) {
+        close_segment(compiler);
+        add_op(compiler, tComma, 0, NULL);
+    }
+
+    append_text(compiler, "\"");
+    append_text(compiler, key);
+    append_text(compiler, "\":");
+
+    compiler->state = sKey;
+}
+
+static void compile_function(template_compiler_t *compiler,
+                             const json_node_t *node) {
+    uint8_t flags = 0;
+
+    if (compiler->state == sMember) {
+        flags |= TEMPLATE_MEMBER_BEFORE;
+    } else if (compiler->state == sDynamic) {
+        flags |= TEMPLATE_CHAINED;
+    }
+
+    close_segment(compiler);
+    add_op(compiler, tFunction, flags, node->contents);
+
+    compiler->state = sDynamic;
+}
+
+static void compile_value(template_compiler_t *compiler,
+                          const json_node_t *node) {
+    close_segment(compiler);
+
+    if (node->type == nString) {
+        add_op(compiler, tString, 0, node->contents);
+    } else {
+        add_op(compiler, tValue, 0, node);
+    }
+
+    compiler->state = sMember;
+}
+
+/* -------------------------------------------------------------------------- */
+
+static void compile_node_list(template_compiler_t *compiler,
+                              const json_node_t *list) {
+    compiler->recursionCount++;
+
+    while (!compiler->done) {
+        const json_node_t *node = list++;
+
+        switch (node->type) {
+        case nControl:
+            switch (((const char *)node->contents)[0]) {
+            case '{':
+                compiler->braceDepth++;
+                append_text(compiler, "{");
+                compiler->state = sOpen;
+                break;
+            case '}':
+                compiler->braceDepth--;
+                append_text(compiler, "}");
+                compiler->state = sMember;
+                if (compiler->braceDepth == 0) {
+                    compiler->done = true;
+                }
+                break;
+            case '\e':
+                compiler->recursionCount--;
+                if (compiler->recursionCount == 0) {
+                    while (compiler->braceDepth) {
+                        compiler->braceDepth--;
+                        append_text(compiler, "}");
+                    }
+                    compiler->done = true;
+                }
+                return;
+            }
+            break;
+        case nNodeList:
+            compile_node_list(compiler, (const json_node_t *)node->contents);
+            break;
+        case nFunction:
+            compile_function(compiler, node);
+            break;
+        case nKey:
+            compile_key(compiler, (const char *)node->contents);
+            break;
+        case nString:
+            append_text(compiler, "\"");
+            compile_value(compiler, node);
+            append_text(compiler, "\"");
+            break;
+        default:
+            compile_value(compiler, node);
+            break;
+        }
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+
+bool json_template_compile(json_template_t *template) {
+    template_compiler_t compiler = {0};
+    compiler.template = template;
+    compiler.state = sOpen;
+
+    // the same trick json_printer_print_fragment() uses, the "\e" at the end
+    // of the list looks like the end of a child list and closes nothing
+    if (template->fragment) {
+        compiler.recursionCount = 1;
+    }
+
+    template->numOps = 0;
+    template->failed = false;
+
+    compile_node_list(&compiler, template->nodeList);
+    close_segment(&compiler);
+
+    template->compiled = true;
+
+    return !template->failed;
+}
+
+/* ************************************************************************** */
+
+void json_template_render(json_printer_t *printer, json_template_t *template) {
+    if (!template->compiled) {
+        json_template_compile(template);
+    }
+
+    // the compiled template didn't fit, so do it the slow way
+    if (template->failed) {
+        if (template->fragment) {
+            json_printer_print_fragment(printer, template->nodeList);
+        } else {
+            json_printer_print(printer, template->nodeList);
+        }
+        return;
+    }
+
+    // true if there's a complete key:value pair before the current function
+    bool member = false;
+
+    for (uint8_t i = 0; i < template->numOps; i++) {
+        const json_template_op_t *op = &template->ops[i];
+
+        switch (op->type) {
+        case tSegment:
+        case tString:
+            json_printer_write(printer, (const char *)op->contents);
+            break;
+        case tValue:
+            json_printer_print_value(printer, (const json_node_t *)op->contents);
+            break;
+        case tComma:
+            if (member) {
+                json_printer_write(printer, ",");
+            }
+            break;
+        case tFunction: {
+            if (!(op->flags & TEMPLATE_CHAINED)) {
+                member = op->flags & TEMPLATE_MEMBER_BEFORE;
+            }
+
+            const json_node_t *result =
+                json_call_function(op->contents, printer->measuring);
+
+            if (result) {
+                if (member && result->type == nKey) {
+                    json_printer_write(printer, ",");
+                }
+                json_printer_print_fragment(printer, result);
+                member = true;
+            }
+            break;
+        }
+        }
+    }
+}
+
+void json_template_print(printer_t destination, json_template_t *template) {
+    json_printer_t printer;
+    json_printer_init(&printer, destination);
+
+    json_template_render(&printer, template);
+}
@@ -0,0 +1,130 @@
+#ifndef _JSON_TEMPLATE_H_
+#define _JSON_TEMPLATE_H_
+
+/* ************************************************************************** */
+
+#include "json_node.h"
+#include "json_print.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+/* ************************************************************************** */
+/*  JSON templates
+
+    Most of a typical node list is constant: keys, braces, colons, commas, and
+    quotes. json_print() has to rediscover all of that structure every time it
+    prints the list, even though the answer never changes.
+
+    A template is a node list that's been "compiled" into a flat sequence of
+    operations. All the constant text is merged into as few literal segments as
+    possible, and the only work left at print time is filling in the holes
+    where the values go.
+
+    Example:
+        const json_node_t jsonBill[] = {
+            {nControl, "{"},
+            {nKey, "name"},
+            {nString, &billsName},
+            {nKey, "age"},
+            {nU16, &billsAge},
+            {nControl, "\e"},
+        };
+
+    compiles to:
+        segment  {"name":"
+        string   &billsName
+        segment  ","age":
+        value    &billsAge
+        segment  }
+
+    The compilation happens the first time the template is printed. If the
+    compiled template doesn't fit in the storage provided, the template falls
+    back to printing the original node list with json_print().
+
+    nFunction nodes can't be resolved in advance, so they're kept as holes and
+    evaluated every time the template is printed. The node list returned by the
+    function should be a set of key:value pairs with balanced braces, like
+    messageID[] or timestamp[].
+*/
+
+// the kinds of operations a compiled template can contain
+typedef enum {
+    tSegment,  // print a literal piece of constant text
+    tValue,    // print the contents of a value node
+    tString,   // print the contents of an nString node, without quotes
+    tComma,    // print a comma if the preceding nFunction printed anything
+    tFunction, // evaluate an nFunction node and print its result
+} template_op_type_t;
+
+// tFunction flags
+#define TEMPLATE_MEMBER_BEFORE 0x01 // a key:value pair precedes this function
+#define TEMPLATE_CHAINED 0x02       // this function follows another function
+
+typedef struct {
+    uint8_t type;
+    uint8_t flags;
+    const void *contents;
+} json_template_op_t;
+
+typedef struct {
+    const json_node_t *nodeList;
+    json_template_op_t *ops;
+    char *text;
+    uint8_t maxOps;
+    uint16_t textSize;
+    uint8_t numOps;
+    unsigned compiled : 1;
+    unsigned failed : 1;
+    unsigned fragment : 1; // leave braces open, like a message preamble
+} json_template_t;
+
+/*  JSON_TEMPLATE() declares a template and the storage it needs
+
+    MAX_OPS is the number of operations the compiled template can hold. Every
+    value or function node needs one, and every stretch of constant text in
+    between needs one more.
+
+    TEXT_SIZE is the number of bytes available for constant text. Each segment
+    is stored with its own null terminator.
+
+    Example:
+    JSON_TEMPLATE(billTemplate, jsonBill, 5, 24);
+*/
+#define JSON_TEMPLATE(NAME, NODE_LIST, MAX_OPS, TEXT_SIZE)                     \
+    static json_template_op_t NAME##_ops[MAX_OPS];                             \
+    static char NAME##_text[TEXT_SIZE];                                        \
+    json_template_t NAME = {NODE_LIST, NAME##_ops, NAME##_text, MAX_OPS,       \
+                            TEXT_SIZE}
+
+/*  JSON_TEMPLATE_FRAGMENT() declares a template for a node list that's only
+    the start of a message, like updatePreamble[]. Braces that are still open
+    at the end of the list are left open, the same way
+    json_printer_print_fragment() leaves them, and the caller prints the rest
+    of the message.
+
+    Example:
+    JSON_TEMPLATE_FRAGMENT(updatePreambleTemplate, updatePreamble, 4, 24);
+
+    json_template_print(usb_print, &updatePreambleTemplate);
+    json_print(usb_print, statusBody);
+*/
+#define JSON_TEMPLATE_FRAGMENT(NAME, NODE_LIST, MAX_OPS, TEXT_SIZE)            \
+    static json_template_op_t NAME##_ops[MAX_OPS];                             \
+    static char NAME##_text[TEXT_SIZE];                                        \
+    json_template_t NAME = {NODE_LIST, NAME##_ops, NAME##_text, MAX_OPS,       \
+                            TEXT_SIZE, 0,          0,           0,       1}
+
+/* ************************************************************************** */
+
+// compile the template ahead of time, returns false if it didn't fit
+extern bool json_template_compile(json_template_t *template);
+
+// print the template using the given printer, compiling it if necessary
+extern void json_template_render(json_printer_t *printer,
+                                 json_template_t *template);
+
+// print the template to 'destination', compiling it if necessary
+extern void json_template_print(printer_t destination,
+                                json_template_t *template);
+
+#endif // _JSON_TEMPLATE_H_
@@ -6,6 +6,9 @@ search_pattern = r'(?<=hash_).*?(?=[:)])'
 
 strings = utils.search('src/usb/messages.c', search_pattern)
 strings.append('message_id')
+strings.append('compression')
+strings.append('shell')
+strings.append('device_info')
 
 strings = list(dict.fromkeys(strings)) # strip duplicates
 
@@ -8,9 +8,13 @@
 #include "judi.h"
 #undef SKIP_JUDI_ENUMS
 
+#include "os/json/json_memo.h"
 #include "os/json/json_print.h"
+#include "os/json/json_template.h"
 #include "os/judi/hash.h"
+#include "os/judi/judi_compress.h"
 #include "os/judi/judi_messages.h"
+#include "os/judi/judi_shell.h"
 #include "os/judi/message_builder.h"
 #include "os/judi/message_id.h"
 #include "os/libs/str_len.h"
@@ -69,6 +73,10 @@ void judi_init(responder_t responder) {
     log_register();
 }
 
+void judi_reset(void) {
+    reset_json_buffer(&buffer[active]); //
+}
+
 bool judi_is_recieving(void) {
     if (buffer[active].depth > 0) {
         return true;
@@ -169,11 +177,40 @@ void preprocess(json_buffer_t *buf) {
     }
 
     grab_message_id(buf);
+    grab_compression_setting(buf);
 }
 
 /* ************************************************************************** */
 
-bool judi_update(char currentChar) {
+// answer {"device_info": ...} from the memo, returns true if we did
+static bool device_info_respond(json_buffer_t *buf) {
+    if (!find_key(buf, ROOT_OBJECT, hash_device_info)) {
+        return false;
+    }
+
+    json_template_print(judi_print, &responsePreambleTemplate);
+    json_memo_print(judi_print, &deviceInfoMemo);
+    judi_print("}}");
+    return true;
+}
+
+// device info and shell requests are answered here, everything else goes to
+// the app
+static void respond(json_buffer_t *buf) {
+    if (device_info_respond(buf)) {
+        return;
+    }
+    if (judi_shell_respond(buf)) {
+        return;
+    }
+    if (response_function) {
+        response_function(buf);
+    }
+}
+
+/* ************************************************************************** */
+
+static bool update(char currentChar) {
     // return early if we don't have a valid character
     if (!isprint(currentChar)) {
         return false;
@@ -211,9 +248,7 @@ bool judi_update(char currentChar) {
             printf("%lu mS\r\n", time);
         });
 
-        if (response_function) {
-            response_function(&buffer[active]);
-        }
+        judi_respond(respond, &buffer[active]);
         LOG_INFO({
             print("Response completed in: ");
             time = time_since(buffer[active].messageStartTime);
@@ -226,4 +261,16 @@ bool judi_update(char currentChar) {
     return true;
 }
 
+/* -------------------------------------------------------------------------- */
+
+bool judi_update(char currentChar) {
+    judi_reply_to(usb_print);
+    return update(currentChar);
+}
+
+bool judi_serial_update(char currentChar) {
+    judi_reply_to(print);
+    return update(currentChar);
+}
+
 #endif
\ No newline at end of file
@@ -72,6 +72,9 @@ typedef struct {
 // only searches inside the given json object
 extern uint8_t find_key(json_buffer_t *buf, int8_t obj, int8_t hash);
 
+// tokenize and hash a complete message, judi_update() calls this
+extern void preprocess(json_buffer_t *buf);
+
 /* ************************************************************************** */
 
 // function pointer definition
@@ -86,4 +89,11 @@ extern bool judi_is_recieving(void);
 // call this often to service the USB port
 extern bool judi_update(char currentChar);
 
+// the same, for messages that arrive on the serial port, see channel_mux.h
+// responses go back out the serial port, and are never compressed
+extern bool judi_serial_update(char currentChar);
+
+// throw away the message that's being received
+extern void judi_reset(void);
+
 #endif // _JUDI_H_
\ No newline at end of file
@@ -0,0 +1,178 @@
+#ifdef USB_ENABLED
+
+#include "judi_compress.h"
+#include "os/json/json_compress.h"
+#include "os/json/json_print.h"
+#include "os/judi/hash.h"
+#include "os/judi/judi_messages.h"
+#include "os/serial_port.h"
+#include "os/shell/shell_command_processor.h"
+#include "os/stopwatch.h"
+#include "os/usb_port.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+/* ************************************************************************** */
+
+static bool compressionEnabled = false;
+
+void judi_set_compression(bool enabled) {
+    compressionEnabled = enabled; //
+}
+
+bool judi_compression_enabled(void) {
+    return compressionEnabled; //
+}
+
+/* -------------------------------------------------------------------------- */
+
+// scans the json buffer for a compression field and applies it if present
+void grab_compression_setting(json_buffer_t *buf) {
+    uint8_t key = find_key(buf, ROOT_OBJECT, hash_compression);
+    if (key) {
+        char *value = TOKEN(key + 1);
+        compressionEnabled = (value[0] == 't' || value[0] == '1');
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+
+/*  The compressor is only needed while a frame is being sent, so it's a local
+    in judi_respond() or judi_send(). On XC8, that puts it in the compiled
+    stack, where it shares RAM with the locals of everything outside the JUDI
+    call tree, instead of permanently taking up its own 270-odd bytes.
+*/
+static json_compressor_t *frame = NULL;
+static bool frameStarted = false;
+
+// the port the current message came from
+static printer_t replyPort = usb_print;
+
+void judi_reply_to(printer_t port) {
+    replyPort = port; //
+}
+
+// only the USB port can carry a frame, see judi_compress.h
+static bool compressing(void) {
+    return compressionEnabled && replyPort == usb_print; //
+}
+
+static void open_frame(json_compressor_t *compressor) {
+    json_compress_begin(compressor, usb_putch);
+    frame = compressor;
+    frameStarted = false;
+}
+
+static void close_frame(void) {
+    // nothing was printed, so there's nothing to end
+    if (frameStarted) {
+        json_compress_end(frame);
+    }
+    frame = NULL;
+}
+
+void judi_print(const char *string) {
+    if (!frame) {
+        replyPort(string);
+        return;
+    }
+
+    if (!frameStarted) {
+        usb_putch(JUDI_COMPRESSED_FRAME);
+        frameStarted = true;
+    }
+    json_compress_write(frame, string);
+}
+
+/* -------------------------------------------------------------------------- */
+
+void judi_respond(responder_t responder, json_buffer_t *buf) {
+    json_compressor_t compressor;
+
+    if (compressing()) {
+        open_frame(&compressor);
+    }
+    responder(buf);
+    if (frame) {
+        close_frame();
+    }
+}
+
+void judi_send(const json_node_t *nodeList) {
+    json_compressor_t compressor;
+
+    // already inside a response, so this is just part of it
+    if (frame || !compressing()) {
+        json_print(judi_print, nodeList);
+        return;
+    }
+
+    open_frame(&compressor);
+    json_print(judi_print, nodeList);
+    close_frame();
+}
+
+/* ************************************************************************** */
+/*  Compression benchmark
+
+    Compresses a sample of real JUDI traffic and reports the compression ratio
+    and how long the compressor took. The output goes to a counting sink, so
+    the time is pure CPU cost and doesn't include the UART.
+*/
+
+#ifdef DEVELOPMENT
+
+// captured from a log dump and a few status updates
+static const char sampleTraffic[] = //
+    "{\"update\":{\"log\":{\"level\":\"info\",\"file\":\"judi.c\",\"line\":141}}}"
+    "{\"update\":{\"log\":{\"level\":\"info\",\"file\":\"judi.c\",\"line\":208}}}"
+    "{\"update\":{\"log\":{\"level\":\"debug\",\"file\":\"judi.c\",\"line\":201}}}"
+    "{\"update\":{\"log\":{\"level\":\"info\",\"file\":\"records.c\",\"line\":61}}}"
+    "{\"update\":{\"status\":{\"time\":104233,\"mode\":\"auto\",\"temp\":21}}}"
+    "{\"update\":{\"status\":{\"time\":104733,\"mode\":\"auto\",\"temp\":21}}}"
+    "{\"update\":{\"status\":{\"time\":105233,\"mode\":\"auto\",\"temp\":22}}}"
+    "{\"message_id\":17,\"response\":\"ok\"}"
+    "{\"message_id\":18,\"response\":\"ok\"}";
+
+static uint16_t benchBytes;
+
+static void counting_sink(char c) {
+    benchBytes++; //
+}
+
+static void print_result(const char *name, uint16_t in, uint16_t out,
+                         uint32_t time) {
+    printf("%-12s %5u -> %5u bytes (%3u%%), %7lu uS", name, in, out,
+           (uint16_t)((uint32_t)out * 100 / (in ? in : 1)), time);
+    if (in) {
+        printf(", %lu uS/byte", time / in);
+    }
+    println("");
+}
+
+SHELL_COMMAND(sh_lzbench, "lzbench");
+
+void sh_lzbench(int argc, char **argv) {
+    json_compressor_t compressor;
+    uint32_t time;
+
+    benchBytes = 0;
+    us_stopwatch_begin();
+    json_compress_begin(&compressor, counting_sink);
+    json_compress_write(&compressor, sampleTraffic);
+    json_compress_end(&compressor);
+    time = us_stopwatch_end();
+    print_result("traffic", compressor.bytesIn, benchBytes, time);
+
+    uint16_t plain = json_measure(deviceInfo);
+    benchBytes = 0;
+    us_stopwatch_begin();
+    json_print_compressed(counting_sink, deviceInfo);
+    time = us_stopwatch_end();
+    print_result("deviceInfo", plain, benchBytes, time);
+}
+
+#endif
+
+#endif
@@ -0,0 +1,72 @@
+#ifndef _JUDI_COMPRESS_H_
+#define _JUDI_COMPRESS_H_
+
+#include "json_node.h"
+#include "json_print.h"
+#include "judi.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+/* ************************************************************************** */
+/*  Compressed JUDI messages
+
+    Compression is off by default, and the host turns it on by including a
+    "compression" key in any message:
+
+        {"compression": true}
+
+    After that, every message is sent as a compressed frame: a single
+    JUDI_COMPRESSED_FRAME byte, followed by the stream described in
+    json_compress.h. Plain JSON messages always start with '{', so the host
+    can tell the two apart by the first byte. The frame ends at the stream's
+    end marker, and the host goes back to reading plain text.
+
+    Responses are printed with judi_print(), a printer_t:
+
+        void my_responder(json_buffer_t *buf) {
+            json_template_print(judi_print, &responsePreambleTemplate);
+            json_print(judi_print, myStatus);
+            judi_print("}}");
+        }
+
+    judi_update() runs the responder inside judi_respond(), which turns
+    everything it prints into a single frame. Anything printed with
+    usb_print() instead goes out uncompressed, and must not be mixed with
+    judi_print() in the same response. Messages that aren't responses, like
+    periodic updates, are sent with judi_send().
+
+    judi_print() goes to the port the last message arrived on: USB for
+    judi_update(), and the serial port for judi_serial_update(). Only USB
+    messages are compressed. The serial port prints strings, which can't
+    carry the zero bytes in a compressed stream, and the stream could contain
+    the channel multiplexer's tag bytes.
+
+    The host can decode the frame with json_decompress.c.
+*/
+
+// the first byte of a compressed frame, ASCII "shift out"
+#define JUDI_COMPRESSED_FRAME 0x0E
+
+/* ************************************************************************** */
+
+// check an incoming message for a "compression" key
+// call this during judi message preprocessing
+extern void grab_compression_setting(json_buffer_t *buf);
+
+// manually control compression
+extern void judi_set_compression(bool enabled);
+extern bool judi_compression_enabled(void);
+
+// print part of a message to the reply port, see above
+extern void judi_print(const char *string);
+
+// choose the reply port, judi.c calls this for every received character
+extern void judi_reply_to(printer_t port);
+
+// call 'responder', and send everything it prints as one frame
+extern void judi_respond(responder_t responder, json_buffer_t *buf);
+
+// send a node list as a complete message, compressed if the host asked for it
+extern void judi_send(const json_node_t *nodeList);
+
+#endif // _JUDI_COMPRESS_H_
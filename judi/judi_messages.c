@@ -1,4 +1,6 @@
 #include "judi_messages.h"
+#include "json_memo.h"
+#include "json_template.h"
 #include "message_id.h"
 #include "os/system_information.h"
 #include "peripherals/device_information.h"
@@ -32,6 +34,11 @@ const json_node_t responsePreamble[] = {
     {nControl, "\e"},   //
 };
 
+// precompiled versions of the preambles, see JSON_TEMPLATE_FRAGMENT()
+JSON_TEMPLATE_FRAGMENT(requestPreambleTemplate, requestPreamble, 4, 24);
+JSON_TEMPLATE_FRAGMENT(updatePreambleTemplate, updatePreamble, 4, 24);
+JSON_TEMPLATE_FRAGMENT(responsePreambleTemplate, responsePreamble, 4, 24);
+
 /* ************************************************************************** */
 // standard responses
 
@@ -51,6 +58,9 @@ const json_node_t responseError[] = {
     {nControl, "\e"},   //
 };
 
+// judi_shell.c answers bad requests itself, so it gets a precompiled version
+JSON_TEMPLATE(responseErrorTemplate, responseError, 6, 24);
+
 /* ************************************************************************** */
 // message components
 
@@ -93,4 +103,8 @@ const json_node_t deviceInfo[] = {
     {nKey, "protocol_version"},          //
     {nString, "1.0.0"},                  //
     {nControl, "\e"},                    //
-};
\ No newline at end of file
+};
+
+// deviceInfo never changes after boot, so only render it once
+// judi.c answers {"device_info": ...} requests with it
+JSON_MEMO(deviceInfoMemo, deviceInfo, 160);
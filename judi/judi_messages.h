@@ -1,7 +1,9 @@
 #ifndef _JSON_MESSAGES_H_
 #define _JSON_MESSAGES_H_
 
+#include "json_memo.h"
 #include "json_node.h"
+#include "json_template.h"
 
 /* ************************************************************************** */
 // message preambles
@@ -10,12 +12,20 @@ extern const json_node_t requestPreamble[];
 extern const json_node_t updatePreamble[];
 extern const json_node_t responsePreamble[];
 
+// precompiled versions of the preambles, see json_template.h
+extern json_template_t requestPreambleTemplate;
+extern json_template_t updatePreambleTemplate;
+extern json_template_t responsePreambleTemplate;
+
 /* ************************************************************************** */
 // standard responses
 
 extern const json_node_t responseOk[];
 extern const json_node_t responseError[];
 
+// precompiled version of responseError, see json_template.h
+extern json_template_t responseErrorTemplate;
+
 /* ************************************************************************** */
 // message components
 
@@ -25,4 +35,7 @@ extern const json_node_t compilation_info[];
 
 extern const json_node_t deviceInfo[];
 
+// rendered once on first use, see json_memo.h
+extern json_memo_t deviceInfoMemo;
+
 #endif // _JSON_MESSAGES_H_
\ No newline at end of file
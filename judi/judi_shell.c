@@ -0,0 +1,209 @@
+#ifdef USB_ENABLED
+
+#define JSMN_STATIC
+#define JSMN_PARENT_LINKS
+#include "os/json/jsmn.h"
+
+#define SKIP_JUDI_ENUMS
+#include "judi.h"
+#undef SKIP_JUDI_ENUMS
+
+#include "judi_shell.h"
+#include "os/json/json_template.h"
+#include "os/judi/judi_compress.h"
+#include "os/judi/hash.h"
+#include "os/judi/judi_messages.h"
+#include "os/serial_port.h"
+#include "os/shell/shell.h"
+#include "os/shell/shell_command_processor.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#ifndef LOGGING_ENABLED
+
+bool judi_shell_respond(json_buffer_t *buf) { return false; }
+
+#else
+
+/* ************************************************************************** */
+
+/*  Captured output is escaped on the way into the buffer, one character at a
+    time, so the buffer can go straight out as the contents of a JSON string.
+*/
+static struct {
+    char output[JUDI_SHELL_OUTPUT_SIZE];
+    uint16_t length;
+    unsigned truncated : 1;
+    unsigned inEscape : 1; // skipping a terminal escape sequence
+    unsigned inCSI : 1;
+} capture;
+
+static void reset_capture(void) {
+    capture.output[0] = '\0';
+    capture.length = 0;
+    capture.truncated = false;
+    capture.inEscape = false;
+    capture.inCSI = false;
+}
+
+static void append(const char *string) {
+    uint8_t length = strlen(string);
+
+    // once something's been dropped, keep the output contiguous
+    if (capture.truncated) {
+        return;
+    }
+
+    // leave room for the null terminator
+    if (capture.length + length >= JUDI_SHELL_OUTPUT_SIZE) {
+        capture.truncated = true;
+        return;
+    }
+
+    memcpy(&capture.output[capture.length], string, length + 1);
+    capture.length += length;
+}
+
+static void capture_char(char c) {
+    // drop terminal escape sequences, like colors and cursor movement
+    if (capture.inEscape) {
+        capture.inEscape = false;
+        capture.inCSI = (c == '[');
+        return;
+    }
+    if (capture.inCSI) {
+        capture.inCSI = !(c >= 0x40 && c <= 0x7e);
+        return;
+    }
+
+    char escaped[3] = {'\\', 0, 0};
+    char plain[2] = {c, 0};
+
+    switch (c) {
+    case '\033':
+        capture.inEscape = true;
+        return;
+    case '"':
+    case '\\':
+        escaped[1] = c;
+        append(escaped);
+        return;
+    case '\r':
+        escaped[1] = 'r';
+        append(escaped);
+        return;
+    case '\n':
+        escaped[1] = 'n';
+        append(escaped);
+        return;
+    case '\t':
+        escaped[1] = 't';
+        append(escaped);
+        return;
+    }
+
+    // any other control characters are meaningless in the output
+    if ((uint8_t)c < ' ') {
+        return;
+    }
+
+    append(plain);
+}
+
+static void capture_string(const char *string) {
+    while (*string) {
+        capture_char(*string++);
+    }
+}
+
+/* ************************************************************************** */
+
+static shell_line_t line;
+
+// run one command, and send its entry in the response array
+static void run_command(const char *command) {
+    const char *result = "ok";
+
+    reset_capture();
+
+    // process_shell_command() chops up the line, so it needs its own copy
+    memset(&line, 0, sizeof(line));
+    strncpy(line.buffer, command, SHELL_MAX_LENGTH - 1);
+    line.length = strlen(line.buffer);
+
+    if (line.length == 0) {
+        result = "not found";
+    } else {
+        // somebody might already own the shell, and they get to keep it
+        shell_callback_t previousCallback = shellCallback;
+        shell_callback_settings_t previousSettings = shellCallbackSettings;
+
+        serial_port_capture(capture_string);
+        int8_t status = process_shell_command(&line);
+        serial_port_capture(NULL);
+
+        if (status == -1) {
+            result = "not found";
+        } else if (shellCallback != previousCallback) {
+            // this would take over the shell, so stop it right away
+            shellCallback = previousCallback;
+            shellCallbackSettings = previousSettings;
+            result = "interactive";
+        }
+    }
+
+    judi_print("{\"command\":\"");
+    judi_print(command);
+    judi_print("\",\"result\":\"");
+    judi_print(result);
+    judi_print("\",\"output\":\"");
+    judi_print(capture.output);
+    judi_print("\"");
+    if (capture.truncated) {
+        judi_print(",\"truncated\":true");
+    }
+    judi_print("}");
+}
+
+/* -------------------------------------------------------------------------- */
+
+bool judi_shell_respond(json_buffer_t *buf) {
+    uint8_t key = find_key(buf, ROOT_OBJECT, hash_shell);
+    if (!key) {
+        return false;
+    }
+    uint8_t value = key + 1;
+
+    // there's nothing to run
+    if (TYPE(value) != JSMN_STRING && TYPE(value) != JSMN_ARRAY) {
+        json_template_print(judi_print, &responseErrorTemplate);
+        return true;
+    }
+
+    json_template_print(judi_print, &responsePreambleTemplate);
+    judi_print("\"shell\":[");
+
+    if (TYPE(value) == JSMN_STRING) {
+        run_command(TOKEN(value));
+    } else {
+        bool first = true;
+        for (uint8_t i = value + 1; i < buf->tokensParsed; i++) {
+            if (PARENT(i) != value || TYPE(i) != JSMN_STRING) {
+                continue;
+            }
+            if (!first) {
+                judi_print(",");
+            }
+            first = false;
+            run_command(TOKEN(i));
+        }
+    }
+
+    judi_print("]}}");
+    return true;
+}
+
+#endif // #ifdef LOGGING_ENABLED
+
+#endif
@@ -0,0 +1,46 @@
+#ifndef _JUDI_SHELL_H_
+#define _JUDI_SHELL_H_
+
+#include "judi.h"
+#include <stdbool.h>
+
+/* ************************************************************************** */
+/*  Shell commands over JUDI
+
+    Automated tests used to drive the shell by typing commands and scraping
+    whatever came back. Instead, a host can ask for any registered shell
+    command to be run, and get its output back as a string in the response:
+
+        {"message_id": 7, "shell": "version"}
+        {"message_id": 8, "shell": ["uptime", "records list", "version -j"]}
+
+    Each command is run with the console captured, so everything it prints
+    ends up in its "output" instead of on the UART. The output is escaped as a
+    JSON string, with terminal colors and other escape sequences removed:
+
+        {"message_id":8,"response":{"shell":[
+            {"command":"uptime","result":"ok","output":"0d 0h 1m 12s\r\n"},
+            {"command":"records list","result":"ok","output":"..."},
+            {"command":"nope","result":"not found","output":""}
+        ]}}
+
+    The output of a single command is limited to JUDI_SHELL_OUTPUT_SIZE bytes,
+    after escaping. Anything past that is dropped, and the command's entry
+    gets "truncated":true. The response is sent as each command finishes, so a
+    batch doesn't need any more RAM than a single command.
+
+    Interactive programs, like logedit, are stopped as soon as they start and
+    report "interactive". This is only available when the shell is
+    (LOGGING_ENABLED).
+*/
+
+// the most output that can be kept from any one command
+#define JUDI_SHELL_OUTPUT_SIZE 256
+
+/* ************************************************************************** */
+
+// if the message has a "shell" key, run the commands and send the response
+// returns true if the message was handled
+extern bool judi_shell_respond(json_buffer_t *buf);
+
+#endif // _JUDI_SHELL_H_
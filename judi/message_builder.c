@@ -1,6 +1,7 @@
 #include "message_builder.h"
 #include "json_node.h"
 #include "json_print.h"
+#include <stdbool.h>
 #include <stdint.h>
 #include <string.h>
 
@@ -13,50 +14,286 @@ const json_node_t closeBraceNode = {nControl, "}"};
 
 /* ************************************************************************** */
 
+// storage for the default builder used by the original API
+static json_node_t defaultNodes[MESSAGE_LENGTH];
+static message_builder_t message = {defaultNodes, MESSAGE_LENGTH};
+
+/* -------------------------------------------------------------------------- */
+
+/*  Streaming mode
+
+    In streaming mode, nodes aren't copied into 'message' at all. Each node is
+    printed the moment it's added, so the size of a message isn't limited by
+    MESSAGE_LENGTH and there's nothing to clear afterwards.
+
+    json_print() decides whether to print a comma by looking at the NEXT node,
+    but when streaming, the next node hasn't been added yet. Instead, the
+    stream remembers whether the last thing it printed was a complete
+    key:value pair, and a key that follows one of those gets a comma in front
+    of it. This is the same rule json_template.c uses.
+*/
 typedef struct {
-    json_node_t nodes[MESSAGE_LENGTH];
+    json_printer_t printer;
+    uint8_t braceDepth;
+    unsigned active : 1;
+    unsigned member : 1; // the last thing printed was a complete key:value
+} message_stream_t;
+
+static message_stream_t stream;
+
+static void stream_nodes(const json_node_t *nodes); // forward dec
+
+static void stream_node(const json_node_t *node) {
+    switch (node->type) {
+    case nControl:
+        switch (((const char *)node->contents)[0]) {
+        case '{':
+            stream.braceDepth++;
+            json_printer_write(&stream.printer, "{");
+            stream.member = false;
+            return;
+        case '}':
+            if (stream.braceDepth) {
+                stream.braceDepth--;
+                json_printer_write(&stream.printer, "}");
+            }
+            stream.member = true;
+            return;
+        }
+        return; // "\e" just ends an included list, nothing to print
+    case nNodeList:
+        stream_nodes((const json_node_t *)node->contents);
+        return;
+    case nFunction: {
+        const json_node_t *result = json_call_function(node->contents, false);
+        if (result) {
+            stream_nodes(result);
+        }
+        return;
+    }
+    case nKey:
+        if (stream.member) {
+            json_printer_write(&stream.printer, ",");
+        }
+        json_printer_print_value(&stream.printer, node);
+        stream.member = false;
+        return;
+    default:
+        json_printer_print_value(&stream.printer, node);
+        stream.member = true;
+        return;
+    }
+}
+
+// stream every node in a list, up to its "\e"
+static void stream_nodes(const json_node_t *nodes) {
+    while (1) {
+        if (nodes->type == nControl) {
+            if (((const char *)nodes->contents)[0] == '\e') {
+                return;
+            }
+        }
+        stream_node(nodes++);
+    }
+}
+
+/* ************************************************************************** */
+/*  Builder pool
+
+    The pool is split into size classes, so a handler that only needs a few
+    nodes doesn't tie up a block big enough for a whole status report. Each
+    class is a fixed array of builders with their node storage right next to
+    them, and acquiring a builder is just finding a free one in the smallest
+    class that's big enough.
+*/
+
+static json_node_t smallNodes[MESSAGE_POOL_SMALL_COUNT]
+                             [MESSAGE_POOL_SMALL_LENGTH];
+static json_node_t largeNodes[MESSAGE_POOL_LARGE_COUNT]
+                             [MESSAGE_POOL_LARGE_LENGTH];
+
+static message_builder_t smallBuilders[MESSAGE_POOL_SMALL_COUNT];
+static message_builder_t largeBuilders[MESSAGE_POOL_LARGE_COUNT];
+
+typedef struct {
+    message_builder_t *builders;
+    json_node_t *nodes;
+    uint8_t count;
     uint8_t length;
-} message_t;
+} pool_class_t;
+
+static const pool_class_t poolClasses[MESSAGE_POOL_CLASSES] = {
+    {smallBuilders, &smallNodes[0][0], MESSAGE_POOL_SMALL_COUNT,
+     MESSAGE_POOL_SMALL_LENGTH},
+    {largeBuilders, &largeNodes[0][0], MESSAGE_POOL_LARGE_COUNT,
+     MESSAGE_POOL_LARGE_LENGTH},
+};
+
+static message_pool_stats_t poolStats[MESSAGE_POOL_CLASSES];
+
+/* -------------------------------------------------------------------------- */
+
+message_builder_t *builder_acquire(uint8_t numberOfNodes) {
+    // failures are charged to the smallest class that was big enough
+    uint8_t failedClass = MESSAGE_POOL_CLASSES - 1;
+    bool fits = false;
+
+    for (uint8_t c = 0; c < MESSAGE_POOL_CLASSES; c++) {
+        const pool_class_t *class = &poolClasses[c];
+
+        // leave room for the end node that builder_print() adds
+        if (numberOfNodes > class->length - 1) {
+            continue;
+        }
+
+        if (!fits) {
+            fits = true;
+            failedClass = c;
+        }
+
+        for (uint8_t i = 0; i < class->count; i++) {
+            message_builder_t *builder = &class->builders[i];
+
+            if (builder->inUse) {
+                continue;
+            }
+
+            builder->nodes = &class->nodes[i * class->length];
+            builder->size = class->length;
+            builder->length = 0;
+            builder->inUse = true;
+            builder->truncated = false;
+
+            poolStats[c].inUse++;
+            if (poolStats[c].inUse > poolStats[c].highWater) {
+                poolStats[c].highWater = poolStats[c].inUse;
+            }
+            return builder;
+        }
+
+        // this class is full, so try the next bigger one
+    }
+
+    // no class had a free builder big enough
+    poolStats[failedClass].failures++;
+    return NULL;
+}
+
+void builder_release(message_builder_t *builder) {
+    if (!builder || !builder->inUse) {
+        return;
+    }
+
+    for (uint8_t c = 0; c < MESSAGE_POOL_CLASSES; c++) {
+        const pool_class_t *class = &poolClasses[c];
+
+        if (builder >= class->builders &&
+            builder < &class->builders[class->count]) {
+            poolStats[c].inUse--;
+            break;
+        }
+    }
+
+    builder->inUse = false;
+}
+
+const message_pool_stats_t *builder_pool_stats(uint8_t sizeClass) {
+    if (sizeClass >= MESSAGE_POOL_CLASSES) {
+        return NULL;
+    }
+    return &poolStats[sizeClass];
+}
 
-static message_t message;
+/* -------------------------------------------------------------------------- */
+
+void builder_reset(message_builder_t *builder) {
+    // nodes past 'length' are never read, so there's no need to clear them
+    builder->length = 0;
+    builder->truncated = false;
+}
+
+/*  The last slot in every builder is reserved for the end node, so adding
+    nodes can never make it impossible to terminate the list. A builder that
+    runs out of room drops the extra nodes and sets 'truncated'.
+*/
+void builder_add_node(message_builder_t *builder, const json_node_t node) {
+    if (builder->length < builder->size - 1) {
+        builder->nodes[builder->length++] = node;
+    } else {
+        builder->truncated = true;
+    }
+}
+
+void builder_add_nodes(message_builder_t *builder, const json_node_t *nodes) {
+    while (1) {
+        if (nodes->type == nControl) {
+            if (((const char *)nodes->contents)[0] == '\e') {
+                return;
+            }
+        }
+        builder_add_node(builder, *nodes++);
+    }
+}
+
+void builder_print(message_builder_t *builder, printer_t destination) {
+    // make sure the node list is terminated
+    builder->nodes[builder->length] = endNode;
+
+    // send the node list to the json printer
+    json_print(destination, &builder->nodes[0]);
+
+    // clear the node list for next time
+    builder_reset(builder);
+}
+
+/* ************************************************************************** */
+// the original API, using the default builder
 
 // clear the temporary message
 void reset_message(void) {
-    //
-    memset(&message, 0, sizeof(message_t));
+    builder_reset(&message); //
 }
 
 // add a single node to the temporary message
 void add_node(const json_node_t node) {
-    if (message.length < MESSAGE_LENGTH) {
-        message.nodes[message.length++] = node;
+    if (stream.active) {
+        stream_node(&node);
+        return;
     }
+
+    builder_add_node(&message, node);
 }
 
 // add a list of nodes to the temporary message
 void add_nodes(const json_node_t *nodes) {
-    uint8_t i = 0;
-
-    while (message.length < MESSAGE_LENGTH) {
-        message.nodes[message.length++] = nodes[i++];
-
-        if (nodes[i].type == nControl) {
-            char c = ((const char *)nodes[i].contents)[0];
-            if (c == '\e') {
-                break;
-            }
-        }
+    if (stream.active) {
+        stream_nodes(nodes);
+        return;
     }
+
+    builder_add_nodes(&message, nodes);
 }
 
 // terminate the message and send it to the specified print destination
 void print_message(printer_t destination) {
-    // make sure the node list is terminated
-    add_node(endNode);
+    builder_print(&message, destination); //
+}
 
-    // send the node list to the json printer
-    json_print(destination, &message.nodes[0]);
+/* -------------------------------------------------------------------------- */
 
-    // clear the node list for next time
-    reset_message();
-}
\ No newline at end of file
+// start a message that's printed to 'destination' as nodes are added
+void begin_message(printer_t destination) {
+    json_printer_init(&stream.printer, destination);
+    stream.braceDepth = 0;
+    stream.member = false;
+    stream.active = true;
+}
+
+// close any open braces and leave streaming mode
+void end_message(void) {
+    while (stream.braceDepth) {
+        stream.braceDepth--;
+        json_printer_write(&stream.printer, "}");
+    }
+    stream.active = false;
+}
@@ -3,13 +3,21 @@
 
 #include "json_node.h"
 #include "json_print.h"
+#include <stdint.h>
 
 /* ************************************************************************** */
 // configuration
 
-// max number of nodes
+// max number of nodes in the default message
 #define MESSAGE_LENGTH 32
 
+// builder pool size classes
+#define MESSAGE_POOL_SMALL_COUNT 4
+#define MESSAGE_POOL_SMALL_LENGTH 8
+#define MESSAGE_POOL_LARGE_COUNT 2
+#define MESSAGE_POOL_LARGE_LENGTH 32
+#define MESSAGE_POOL_CLASSES 2
+
 /* ************************************************************************** */
 // special nodes, for use with the builder
 
@@ -18,6 +26,68 @@ extern const json_node_t openBraceNode;
 extern const json_node_t closeBraceNode;
 
 /* ************************************************************************** */
+/*  Message builders
+
+    The original API below uses a single static message, which means only one
+    message can be under construction at a time. A handler that triggers a log
+    message while it's building a response would corrupt the response.
+
+    Producers that might overlap should acquire their own builder from the
+    pool instead. Builders come in a small number of size classes, and
+    builder_acquire() hands out a free builder from the smallest class that
+    can hold the requested number of nodes. It returns NULL if there isn't one,
+    so check the result!
+
+    Example:
+    message_builder_t *builder = builder_acquire(4);
+    if (builder) {
+        builder_add_node(builder, openBraceNode);
+        builder_add_node(builder, messageIdNode);
+        builder_add_nodes(builder, responseBody);
+        builder_print(builder, usb_print);
+        builder_release(builder);
+    }
+*/
+
+typedef struct {
+    json_node_t *nodes;
+    uint8_t size;
+    uint8_t length;
+    unsigned inUse : 1;
+    unsigned truncated : 1; // nodes were dropped, check it before printing
+} message_builder_t;
+
+typedef struct {
+    uint8_t inUse;
+    uint8_t highWater; // the most builders that have ever been in use at once
+    uint8_t failures;  // builder_acquire() returned NULL, and this was the
+                       // smallest class big enough for the request
+} message_pool_stats_t;
+
+// get a builder that can hold at least 'numberOfNodes', or NULL if none are free
+extern message_builder_t *builder_acquire(uint8_t numberOfNodes);
+
+// return a builder to the pool
+extern void builder_release(message_builder_t *builder);
+
+// usage statistics for the given size class, 0 is the smallest
+extern const message_pool_stats_t *builder_pool_stats(uint8_t sizeClass);
+
+// clear the builder's message and its 'truncated' flag
+extern void builder_reset(message_builder_t *builder);
+
+// add a single node to the builder's message
+extern void builder_add_node(message_builder_t *builder, const json_node_t node);
+
+// add a list of nodes to the builder's message
+extern void builder_add_nodes(message_builder_t *builder,
+                              const json_node_t *nodes);
+
+// terminate the builder's message, print it, and reset the builder
+extern void builder_print(message_builder_t *builder, printer_t destination);
+
+/* ************************************************************************** */
+// the original API, which uses a default builder
 
 // clear the temporary message
 extern void reset_message(void);
@@ -31,4 +101,26 @@ extern void add_nodes(const json_node_t *nodes);
 // terminate the message and send it to the specified print destination
 extern void print_message(printer_t destination);
 
+/* -------------------------------------------------------------------------- */
+/*  Streaming messages
+
+    Between begin_message() and end_message(), add_node() and add_nodes() don't
+    copy anything into the temporary message. Each node is printed directly to
+    'destination' as soon as it's added, so a streamed message can be any
+    length. end_message() closes any braces that are still open.
+
+    Example:
+    begin_message(usb_print);
+    add_node(openBraceNode);
+    add_node(messageIdNode);
+    add_nodes(bigNodeList);
+    end_message();
+*/
+
+// start a message that's printed to 'destination' as nodes are added
+extern void begin_message(printer_t destination);
+
+// close any open braces and leave streaming mode
+extern void end_message(void);
+
 #endif // _MESSAGE_BUILDER_H_
\ No newline at end of file
@@ -1,4 +1,5 @@
 #include "message_id.h"
+#include "json_print.h"
 #include "os/judi/hash.h"
 #include <stdlib.h>
 #include <string.h>
@@ -39,8 +40,11 @@ const json_node_t messageID[] = {
 // 'private' function to optionally print the message id
 const json_node_t *_get_message_id(void) {
     if (needToSendID) {
-        needToSendID = false;
-        return &messageID;
+        // measuring isn't sending, so the id is still needed afterwards
+        if (!json_printer_is_measuring()) {
+            needToSendID = false;
+        }
+        return messageID;
     } else {
         return NULL;
     }
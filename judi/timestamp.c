@@ -15,7 +15,7 @@ const json_node_t timestamp[] = {
 // make sure the temp timestamp is updated
 const json_node_t *_get_timestamp(void) {
     timeCache = get_current_time();
-    return &timestamp;
+    return timestamp;
 }
 
 // json function wrapper node
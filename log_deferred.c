@@ -0,0 +1,149 @@
+#include "log_deferred.h"
+#include "channel_mux.h"
+#include "serial_port.h"
+#include "system_time.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifndef LOGGING_ENABLED
+
+void log_defer__(uint16_t id, const uint32_t *args, uint8_t count) {}
+bool attempt_log_drain(void) { return false; }
+
+#else
+
+/* ************************************************************************** */
+
+/*  Message storage
+
+    Messages are packed into a 256 byte ring, the same way as shell history:
+    a length byte, followed by the message. Because the ring is exactly 256
+    bytes long, every index is a uint8_t and wraps around all by itself.
+
+    A message is a list of varints:
+        <site ID> <timestamp> <arg 1> ... <arg n>
+
+    A varint stores 7 bits per byte, low bits first, and the high bit is set
+    on every byte except the last. Values under 128 take one byte, and the
+    biggest possible uint32_t takes five.
+*/
+
+#define RING_SIZE 256
+
+// the most bytes a single varint can take up
+#define MAX_VARINT_SIZE 5
+
+// the biggest possible message, not counting its length byte
+#define MAX_MESSAGE_SIZE (MAX_VARINT_SIZE * (DLOG_MAX_ARGS + 2))
+
+// drained as "~<hex>\r\n", with room for a channel tag
+#define MAX_LINE_SIZE (1 + MAX_MESSAGE_SIZE * 2 + 2 + 1)
+
+static struct {
+    uint8_t ring[RING_SIZE];
+    uint8_t tail; // the length byte of the oldest message
+    uint8_t head; // where the next message will go
+    uint32_t dropped;
+} deferred;
+
+// the number of bytes currently in use. The ring is never allowed to fill up
+// completely, so head == tail always means it's empty.
+#define bytes_used() (uint8_t)(deferred.head - deferred.tail)
+
+/* -------------------------------------------------------------------------- */
+
+// write 'value' to 'buffer', returns the number of bytes used
+static uint8_t put_varint(uint8_t *buffer, uint32_t value) {
+    uint8_t length = 0;
+
+    while (value >= 0x80) {
+        buffer[length++] = (value & 0x7f) | 0x80;
+        value >>= 7;
+    }
+    buffer[length++] = value;
+
+    return length;
+}
+
+// add a message to the ring, returns false if it doesn't fit
+static bool store_message(uint16_t id, const uint32_t *args, uint8_t count) {
+    uint8_t message[MAX_MESSAGE_SIZE];
+    uint8_t length = 0;
+
+    length += put_varint(&message[length], id);
+    length += put_varint(&message[length], get_current_time());
+    for (uint8_t i = 0; i < count; i++) {
+        length += put_varint(&message[length], args[i]);
+    }
+
+    if (RING_SIZE - 1 - bytes_used() < length + 1) {
+        return false;
+    }
+
+    deferred.ring[deferred.head++] = length;
+    for (uint8_t i = 0; i < length; i++) {
+        deferred.ring[deferred.head++] = message[i];
+    }
+    return true;
+}
+
+/* ************************************************************************** */
+
+void log_defer__(uint16_t id, const uint32_t *args, uint8_t count) {
+    if (count > DLOG_MAX_ARGS) {
+        count = DLOG_MAX_ARGS;
+    }
+
+    // report any earlier losses first, so they show up in the right place
+    if (deferred.dropped) {
+        if (!store_message(dlog_dropped, &deferred.dropped, 1)) {
+            deferred.dropped++;
+            return;
+        }
+        deferred.dropped = 0;
+    }
+
+    if (!store_message(id, args, count)) {
+        deferred.dropped++;
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+
+static const char hexDigits[] = "0123456789ABCDEF";
+
+// send the oldest message as one line of hex
+static void drain_message(void) {
+    char line[MAX_LINE_SIZE];
+    uint8_t length = deferred.ring[deferred.tail++];
+    uint8_t i = 0;
+
+    line[i++] = DLOG_MARKER;
+    while (length--) {
+        uint8_t byte = deferred.ring[deferred.tail++];
+        line[i++] = hexDigits[byte >> 4];
+        line[i++] = hexDigits[byte & 0x0f];
+    }
+    line[i] = '\0';
+
+    println(line);
+}
+
+bool attempt_log_drain(void) {
+    if (bytes_used() == 0) {
+        return false;
+    }
+
+    channel_t previous = channel_mux_select(CHANNEL_LOG);
+
+    bool drained = false;
+    while (bytes_used() && serial_port_tx_space() >= MAX_LINE_SIZE) {
+        drain_message();
+        drained = true;
+    }
+
+    channel_mux_select(previous);
+    return drained;
+}
+
+#endif // #ifdef LOGGING_ENABLED
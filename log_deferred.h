@@ -0,0 +1,166 @@
+#ifndef _LOG_DEFERRED_H_
+#define _LOG_DEFERRED_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "logging.h"
+
+/* ************************************************************************** */
+/*  Deferred logging
+
+    LOG_XXX() prints a timestamp, a colored level name, and a file name, and
+    then runs printf() on the message, all before it returns. That's fine for
+    the occasional message, but turning on DEBUG in a busy module wrecks the
+    timing of the whole superloop.
+
+    DLOG_XXX() does as little as possible at the call site. Every log site has
+    a name, which becomes an ID at build time, and only the ID, the time, and
+    the raw values of the arguments are stored:
+
+        DLOG_DEBUG(tune_step, "freq: %u, swr: %u", frequency, swr);
+
+    The format string is never compiled into the firmware. Instead, the
+    generator below collects every DLOG_XXX() site in the project into a
+    dictionary (log_dictionary.c) of format strings, levels, and file:line,
+    which a host tool uses to turn the stored values back into text. The
+    dictionary and the decoder live in host/, so they're never part of the
+    firmware. See host/log_decode.h.
+
+    Messages are kept in a 256 byte ring until attempt_log_drain() has room to
+    send them, so it needs to be called from the superloop:
+
+        while (1) {
+            attempt_log_drain();
+            ...
+        }
+
+    Each message goes out on its own line as a '~' followed by hex:
+
+        ~0C82B40407E1
+
+    Arguments must be integers or chars, and there can be up to
+    DLOG_MAX_ARGS of them. Each one is stored as a varint, so small values are
+    cheap. If the ring is full, messages are dropped, and the number of
+    dropped messages is sent as soon as there's room again.
+
+    Site names must be unique across the whole project. DLOG_XXX() uses the
+    file's LOG_LEVEL and LOG_LEVEL_MAX, just like LOG_XXX().
+*/
+
+// the most arguments a single message can have
+#define DLOG_MAX_ARGS 4
+
+// marks a line of deferred log output
+#define DLOG_MARKER '~'
+
+/* [[[cog
+import re
+import codegen as code
+from pathlib import Path
+
+site = re.compile(
+    r'DLOG_(TRACE|DEBUG|INFO|WARN|ERROR|FATAL)\(\s*(\w+)\s*,\s*"((?:[^"\\]|\\.)*)"')
+conversion = re.compile(r'%[-+ #0]*\d*(?:\.\d*)?[lh]?([a-zA-Z%])')
+levels = ['SILENT', 'FATAL', 'ERROR', 'WARN', 'INFO', 'DEBUG', 'TRACE']
+maxArgs = 4 # must match DLOG_MAX_ARGS
+
+# ID 0 is reserved for the dropped message count
+sites = [('dropped', 'WARN', str(Path(cog.inFile).with_suffix('.c')), 0,
+          '%lu messages dropped')]
+for path in sorted(Path('src').rglob('*.c')):
+    text = path.read_text()
+    for match in site.finditer(text):
+        level, name, fmt = match.groups()
+        line = text.count('\n', 0, match.start()) + 1
+
+        if name in [s[0] for s in sites]:
+            raise Exception(f'{path}:{line}: duplicate log site name: {name}')
+
+        args = [c for c in conversion.findall(fmt) if c != '%']
+        if len(args) > maxArgs:
+            raise Exception(f'{path}:{line}: too many arguments: {name}')
+        if 's' in args:
+            raise Exception(f'{path}:{line}: %s can not be deferred: {name}')
+
+        sites.append((name, level, str(path), line, fmt))
+
+enum = code.Enum('log_site_t', values=[f'dlog_{s[0]}' for s in sites],
+                 typedef=True, explicit=True)
+
+header = code.HeaderFile(
+    name = Path(Path(cog.inFile).parent, 'log_sites.h'),
+    includes = '<stdint.h>',
+    contents = [enum.assemble()]
+)
+
+entries = [
+    f'    {{{levels.index(level)}, "{path}", {line}, "{fmt}"}}, // {name}'
+    for name, level, path, line, fmt in sites
+]
+
+# only used by host tools, so it goes in host/ with log_decode.c
+table = '\n'.join([
+    'const log_dictionary_entry_t logDictionary[] = {',
+    *entries,
+    '};',
+    '',
+    'const uint16_t logDictionaryLength =',
+    '    sizeof(logDictionary) / sizeof(log_dictionary_entry_t);',
+])
+
+source = code.SourceFile(
+    name = Path(Path(cog.inFile).parent, 'host', 'log_dictionary.c'),
+    includes = ['<stdint.h>', '"log_decode.h"'],
+    contents = [table]
+)
+
+header.write()
+source.write()
+
+cog.outl(f'#include "{header.name}"')
+
+]]] */
+#include "log_sites.h"
+/* [[[end]]] */
+
+/* ************************************************************************** */
+
+//! Do not call directly. Use DLOG_XXXX() wrapper macros defined below.
+extern void log_defer__(uint16_t id, const uint32_t *args, uint8_t count);
+
+#ifdef LOGGING_ENABLED
+
+// the extra element keeps the array from being empty when there are no args
+#define DLOG__(LEVEL, NAME, ...)                                               \
+    if (LEVEL <= LOG_LEVEL_MAX && LEVEL <= LOG_LEVEL) {                        \
+        const uint32_t dlogArgs[] = {0, __VA_ARGS__};                          \
+        log_defer__(dlog_##NAME, &dlogArgs[1],                                 \
+                    sizeof(dlogArgs) / sizeof(uint32_t) - 1);                  \
+    }
+
+#define DLOG_TRACE(NAME, FORMAT, ...) DLOG__(L_TRACE, NAME, __VA_ARGS__)
+#define DLOG_DEBUG(NAME, FORMAT, ...) DLOG__(L_DEBUG, NAME, __VA_ARGS__)
+#define DLOG_INFO(NAME, FORMAT, ...) DLOG__(L_INFO, NAME, __VA_ARGS__)
+#define DLOG_WARN(NAME, FORMAT, ...) DLOG__(L_WARN, NAME, __VA_ARGS__)
+#define DLOG_ERROR(NAME, FORMAT, ...) DLOG__(L_ERROR, NAME, __VA_ARGS__)
+#define DLOG_FATAL(NAME, FORMAT, ...) DLOG__(L_FATAL, NAME, __VA_ARGS__)
+
+#else // #ifdef LOGGING_ENABLED
+
+#define DLOG_TRACE(NAME, FORMAT, ...)
+#define DLOG_DEBUG(NAME, FORMAT, ...)
+#define DLOG_INFO(NAME, FORMAT, ...)
+#define DLOG_WARN(NAME, FORMAT, ...)
+#define DLOG_ERROR(NAME, FORMAT, ...)
+#define DLOG_FATAL(NAME, FORMAT, ...)
+
+#endif // #ifdef LOGGING_ENABLED
+
+/* ************************************************************************** */
+
+// send as many stored messages as there's room for
+// returns true if anything was sent
+extern bool attempt_log_drain(void);
+
+#endif // _LOG_DEFERRED_H_
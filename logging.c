@@ -1,5 +1,5 @@
 #include "logging.h"
-#include "os/libs/str_len.h"
+#include "channel_mux.h"
 #include "os/shell/shell_command_utils.h"
 #include "serial_port.h"
 #include "shell/shell_utils.h"
@@ -12,23 +12,52 @@
 
 void logging_init(void) {}
 void log_fix_shortnames(void) {}
-void log_register__(const char *name, uint8_t *levelPtr) {}
-void log_level_edit(uint8_t fileID, uint8_t level) {}
+uint8_t log_register__(const char *name, uint8_t *levelPtr, uint8_t maxLevel) {
+    return LOG_NO_FILE;
+}
+uint8_t look_up_file_id(const char *filename) { return LOG_NO_FILE; }
+bool log_level_edit(uint8_t fileID, uint8_t level) { return false; }
+bool set_log_level(const char *filename, uint8_t level) { return false; }
+bool push_log_level(const char *filename, uint8_t level) { return false; }
+bool pop_log_level(const char *filename) { return false; }
 void print_log_level(uint8_t level) {}
-void print_log_header(uint8_t msgLevel, const char *file, int line) {}
+channel_t print_log_header(uint8_t msgLevel, uint8_t *levelPtr,
+                           const char *file, int line) {
+    return CHANNEL_LOG;
+}
+void print_log_footer(channel_t previous) {}
 
 #else
 
 /* ************************************************************************** */
 
-const char *level_names[] = {
-    "SILENT", "FATAL", "ERROR", "WARN", "INFO", "DEBUG", "TRACE",
-};
-
-const char *level_colors[] = {
-    "\033[1;37m", "\033[1;35m", "\033[1;31m", "\033[1;33m",
-    "\033[1;32m", "\033[1;36m", "\033[1;34m",
-};
+/*  Everything about how each level looks, in one place: its name, the name
+    padded to the width of the level column, and its color, as an ANSI color
+    number (the same order as the colors in shell_screen.h).
+*/
+#define LOG_LEVEL_LIST                                                         \
+    X("SILENT", "SILENT", 7)                                                   \
+    X("FATAL", "FATAL ", 5)                                                    \
+    X("ERROR", "ERROR ", 1)                                                    \
+    X("WARN", "WARN  ", 3)                                                     \
+    X("INFO", "INFO  ", 2)                                                     \
+    X("DEBUG", "DEBUG ", 6)                                                    \
+    X("TRACE", "TRACE ", 4)
+
+#define LEVEL_COLOR(COLOR) "\033[1;3" #COLOR "m"
+
+#define X(NAME, PADDED, COLOR) NAME,
+const char *level_names[] = {LOG_LEVEL_LIST};
+#undef X
+
+#define X(NAME, PADDED, COLOR) LEVEL_COLOR(COLOR),
+const char *level_colors[] = {LOG_LEVEL_LIST};
+#undef X
+
+// the output of print_log_level() for each level, built at compile time
+#define X(NAME, PADDED, COLOR) LEVEL_COLOR(COLOR) PADDED TXT_RESET,
+static const char *levelPrefixes[] = {LOG_LEVEL_LIST};
+#undef X
 
 log_database_t logDatabase;
 
@@ -36,7 +65,47 @@ log_features_t logFeatures = {true, true, true, true, true};
 
 /* -------------------------------------------------------------------------- */
 
-void logedit(int argc, char **argv);
+SHELL_COMMAND(logedit, "logedit");
+
+// the part of a path after the last '/'
+static const char *find_short_name(const char *path) {
+    const char *shortName = path;
+
+    while (*path) {
+        if (*path++ == '/') {
+            shortName = path;
+        }
+    }
+
+    return shortName;
+}
+
+/* -------------------------------------------------------------------------- */
+// the registry, see log_database_t in logging.h
+
+#define EMPTY_SLOT 0
+
+#define next_slot(slot) (((slot) + 1) & (LOG_REGISTRY_SIZE - 1))
+
+// rotate and xor, cheap on a PIC and good enough to spread out file names
+static uint8_t hash_name(const char *name) {
+    uint8_t hash = 0;
+
+    while (*name) {
+        hash = (uint8_t)((hash << 1) | (hash >> 7)) ^ *name++;
+    }
+
+    return hash & (LOG_REGISTRY_SIZE - 1);
+}
+
+// every file's LOG_LEVEL is a different variable, so its address is unique
+static uint8_t hash_level(uint8_t *levelPtr) {
+    uint16_t address = (uint16_t)(size_t)levelPtr;
+
+    return (uint8_t)(address ^ (address >> 8)) & (LOG_REGISTRY_SIZE - 1);
+}
+
+/* -------------------------------------------------------------------------- */
 
 void logging_init(void) {
     for (uint8_t i = 0; i < MAX_NUMBER_OF_FILES; i++) {
@@ -45,113 +114,230 @@ void logging_init(void) {
     }
     logDatabase.numberOfFiles = 0;
 
-    shell_register_command(logedit, "logedit");
+    memset(logDatabase.slot, EMPTY_SLOT, LOG_REGISTRY_SIZE);
+    memset(logDatabase.levelSlot, EMPTY_SLOT, LOG_REGISTRY_SIZE);
 }
 
-void log_register__(const char *name, uint8_t *levelPtr) {
+uint8_t log_register__(const char *name, uint8_t *levelPtr, uint8_t maxLevel) {
+    const char *shortName = find_short_name(name);
+    uint8_t slot = hash_name(shortName);
+
     // make sure we're not double-registering
-    for (uint8_t i = 0; i < MAX_NUMBER_OF_FILES; i++) {
-        if (!strcmp(name, logDatabase.file[i].name)) {
-            return; // file is already registered
+    while (logDatabase.slot[slot] != EMPTY_SLOT) {
+        uint8_t id = logDatabase.slot[slot] - 1;
+        log_level_t *file = &logDatabase.file[id];
+
+        if (file->levelPtr == levelPtr || !strcmp(file->name, name)) {
+            return id; // file is already registered
         }
+        slot = next_slot(slot);
+    }
+
+    if (logDatabase.numberOfFiles >= MAX_NUMBER_OF_FILES) {
+        printf("can't register %s, MAX_NUMBER_OF_FILES is %d\r\n", name,
+               MAX_NUMBER_OF_FILES);
+        return LOG_NO_FILE;
     }
 
     // We're good, register the file
-    log_level_t file;
-    file.name = name;
-    file.levelPtr = levelPtr;
-
-    // fix the shortname pointer
-    for (uint8_t j = str_len(file.name); j > 0; j--) {
-        if (file.name[j] == '/') {
-            file.shortName = &file.name[j + 1];
-            break;
-        }
+    uint8_t id = logDatabase.numberOfFiles++;
+    log_level_t *file = &logDatabase.file[id];
+
+    file->name = name;
+    file->levelPtr = levelPtr;
+    file->maxLevel = maxLevel;
+
+    // a file's LOG_LEVEL can start out above its LOG_LEVEL_MAX, but it can't
+    // be set that way afterwards, so logedit shouldn't ever see it
+    if (*levelPtr > maxLevel) {
+        *levelPtr = maxLevel;
+    }
+
+    // log headers use this instead of searching the name every time
+    file->shortName = shortName;
+
+    logDatabase.slot[slot] = id + 1;
+
+    slot = hash_level(levelPtr);
+    while (logDatabase.levelSlot[slot] != EMPTY_SLOT) {
+        slot = next_slot(slot);
     }
+    logDatabase.levelSlot[slot] = id + 1;
 
-    logDatabase.file[logDatabase.numberOfFiles] = file;
-    logDatabase.numberOfFiles++;
+    return id;
 }
 
 /* ************************************************************************** */
 
-void log_level_edit(uint8_t fileID, uint8_t level) {
+bool log_level_edit(uint8_t fileID, uint8_t level) {
+    if (fileID >= logDatabase.numberOfFiles) {
+        return false;
+    }
+
+    // anything above the ceiling was compiled out anyway
+    if (level > logDatabase.file[fileID].maxLevel) {
+        level = logDatabase.file[fileID].maxLevel;
+    }
     *logDatabase.file[fileID].levelPtr = level;
+    return true;
 }
 
 uint8_t look_up_file_id(const char *filename) {
-    for (uint8_t i = 0; i < logDatabase.numberOfFiles; i++) {
-        if (!strcmp(filename, logDatabase.file[i].shortName)) {
-            return i;
+    const char *shortName = find_short_name(filename);
+    bool isPath = (shortName != filename);
+    uint8_t slot = hash_name(shortName);
+
+    // the table is never full, so there's always an empty slot to stop at
+    while (logDatabase.slot[slot] != EMPTY_SLOT) {
+        uint8_t id = logDatabase.slot[slot] - 1;
+        log_level_t *file = &logDatabase.file[id];
+
+        if (isPath) {
+            if (!strcmp(filename, file->name)) {
+                return id;
+            }
+        } else if (!strcmp(filename, file->shortName)) {
+            return id;
         }
+        slot = next_slot(slot);
     }
 
-    return 0;
+    return LOG_NO_FILE;
 }
 
-void set_log_level(const char *filename, uint8_t level) {
+bool set_log_level(const char *filename, uint8_t level) {
     uint8_t id = look_up_file_id(filename);
 
-    log_level_edit(id, level);
+    return log_level_edit(id, level);
 }
 
 /* -------------------------------------------------------------------------- */
 
 static uint8_t savedLevel = 0;
 
-void push_log_level(const char *filename, uint8_t level) {
+bool push_log_level(const char *filename, uint8_t level) {
     uint8_t id = look_up_file_id(filename);
+    if (id == LOG_NO_FILE) {
+        return false;
+    }
 
     savedLevel = *logDatabase.file[id].levelPtr;
 
-    log_level_edit(id, level);
+    return log_level_edit(id, level);
 }
 
-void pop_log_level(const char *filename) {
+bool pop_log_level(const char *filename) {
     uint8_t id = look_up_file_id(filename);
 
-    log_level_edit(id, savedLevel);
+    return log_level_edit(id, savedLevel);
 }
 
 void print_log_level(uint8_t level) {
-    printf("%s%-6s", level_colors[level], level_names[level]);
-    reset_text_attributes();
+    sh_print(levelPrefixes[level]); //
 }
 
 /* -------------------------------------------------------------------------- */
 
-void print_log_header(uint8_t msgLevel, const char *file, int line) {
+// the longest uint32_t, plus a separator and a null
+#define NUMBER_BUFFER_SIZE 12
+
+static const uint32_t powersOfTen[] = {
+    1000000000, 100000000, 10000000, 1000000, 100000,
+    10000,      1000,      100,      10,      1,
+};
+
+/*  Write 'value' in decimal, followed by 'separator', and null terminate it.
+
+    printf("%lu") has to do a 32 bit division for every digit, which is very
+    slow on a PIC. Repeatedly subtracting powers of ten gives the same answer
+    with nothing but subtraction, at most nine times per digit.
+*/
+static void format_number(char *buffer, uint32_t value, char separator) {
+    bool leadingZero = true;
+
+    for (uint8_t i = 0; i < sizeof(powersOfTen) / sizeof(uint32_t); i++) {
+        char digit = '0';
+        while (value >= powersOfTen[i]) {
+            value -= powersOfTen[i];
+            digit++;
+        }
+
+        // the last digit is always printed, even if it's a zero
+        if (digit != '0' || !leadingZero || powersOfTen[i] == 1) {
+            leadingZero = false;
+            *buffer++ = digit;
+        }
+    }
+
+    *buffer++ = separator;
+    *buffer = '\0';
+}
+
+/* -------------------------------------------------------------------------- */
+
+/*  Every message from a file uses that file's registration record, which has
+    its short name already worked out. The record is found through the
+    registry's second hash table, with the address of the file's LOG_LEVEL as
+    the key. Files that never called log_register() don't have a record.
+*/
+static log_level_t *find_file(uint8_t *levelPtr) {
+    uint8_t slot = hash_level(levelPtr);
+
+    while (logDatabase.levelSlot[slot] != EMPTY_SLOT) {
+        log_level_t *file = &logDatabase.file[logDatabase.levelSlot[slot] - 1];
+
+        if (file->levelPtr == levelPtr) {
+            return file;
+        }
+        slot = next_slot(slot);
+    }
+
+    return NULL;
+}
+
+/* -------------------------------------------------------------------------- */
+
+channel_t print_log_header(uint8_t msgLevel, uint8_t *levelPtr,
+                           const char *file, int line) {
+    char number[NUMBER_BUFFER_SIZE];
+
+    channel_t previous = channel_mux_select(CHANNEL_LOG);
+
     reset_text_attributes();
     if (!logFeatures.printHeader) {
-        return;
+        return previous;
     }
 
     if (logFeatures.printTimestamp) {
-        printf("%lu ", get_current_time());
+        format_number(number, get_current_time(), ' ');
+        sh_print(number);
     }
 
     if (logFeatures.printLogLevel) {
         print_log_level(msgLevel);
     }
 
-    reset_text_attributes();
-
     if (logFeatures.printFileName) {
         if (logFeatures.useShortNames) {
-            const char *shortFileName;
-            for (uint8_t i = str_len(file); i > 0; i--) {
-                if (file[i] == '/') {
-                    shortFileName = &file[i + 1];
-                    break;
-                }
+            log_level_t *record = find_file(levelPtr);
+            if (record) {
+                file = record->shortName;
+            } else {
+                file = find_short_name(file);
             }
-            printf(" %s:%d: ", shortFileName, line);
-        } else {
-            printf(" %s:%d: ", file, line);
         }
+
+        sh_print(" ");
+        sh_print(file);
+        number[0] = ':';
+        format_number(&number[1], line, ':');
+        sh_print(number);
+        sh_print(" ");
     }
+}
 
-    reset_text_attributes();
+void print_log_footer(channel_t previous) {
+    channel_mux_select(previous); //
 }
 
 /* ************************************************************************** */
@@ -159,6 +345,7 @@ void print_log_header(uint8_t msgLevel, const char *file, int line) {
 #include "os/shell/shell.h"
 #include "os/shell/shell_command_utils.h"
 #include "os/shell/shell_keys.h"
+#include "os/shell/shell_screen.h"
 #include "os/shell/shell_utils.h"
 
 /* ************************************************************************** */
@@ -171,118 +358,111 @@ static uint8_t newLogDatabase[MAX_NUMBER_OF_FILES];
 static uint8_t selectedLine = 0;
 static uint8_t selectedLevel = 0;
 
-#define COLUMN_NUMBER 7
+/* -------------------------------------------------------------------------- */
 
-void reprint_line(void) {
-    term_cursor_home();
-    term_cursor_right(COLUMN_NUMBER);
-    print_log_level(newLogDatabase[selectedLine]);
-    term_cursor_home();
-    term_cursor_right(COLUMN_NUMBER);
-}
+// the screen versions of level_colors[]
+#define X(NAME, PADDED, COLOR) SCREEN_BOLD | COLOR,
+static const uint8_t level_attributes[] = {LOG_LEVEL_LIST};
+#undef X
 
-/* -------------------------------------------------------------------------- */
+#define HORIZONTAL_RULE "-----------------------------------------------\n"
+
+// the header, footer, and one row per file
+#define LOGEDIT_HEIGHT (8 + MAX_NUMBER_OF_FILES)
+
+#if SHELL_SCREEN_HEIGHT < LOGEDIT_HEIGHT
+#warning "SHELL_SCREEN_HEIGHT is too small for logedit, the table will be cut off"
+#endif
 
-// This should be the number of newlines printed by print_logedit_header()
-#define HEADER_HEIGHT 5
+// the file name column starts after " #NN | level  | max    | "
+#define NAME_COLUMN 25
+#define NAME_WIDTH (SHELL_SCREEN_WIDTH - NAME_COLUMN)
 
-void print_logedit_header(void) {
-    println("-----------------------------------------------");
-    printf("%d files are currently registered.\r\n", logDatabase.numberOfFiles);
-    println("");
+void draw_log_level(uint8_t level, uint8_t attributes) {
+    screen_set_attr(level_attributes[level] | attributes);
+    screen_printf("%-6s", level_names[level]);
+    screen_set_attr(SCREEN_DEFAULT);
+}
+
+void draw_logedit_header(void) {
+    screen_print(HORIZONTAL_RULE);
+    screen_printf("%d files are currently registered.\n",
+                  logDatabase.numberOfFiles);
+    screen_print("\n");
     if (logFeatures.useShortNames) {
-        println(" #   | level  | file name");
+        screen_print(" #   | level  | max    | file name\n");
     } else {
-        println(" #   | level  | path/to/file");
+        screen_print(" #   | level  | max    | path/to/file\n");
     }
-    println("-----------------------------------------------");
+    screen_print(HORIZONTAL_RULE);
 }
 
-void print_managed_log_table(void) {
+/*  Full paths are usually too long for the screen. The end of the path is what
+    tells files apart, so a long path loses its beginning instead.
+*/
+static void draw_file_name(const char *name) {
+    size_t length = strlen(name);
+
+    if (length > NAME_WIDTH) {
+        screen_print("...");
+        name += length - (NAME_WIDTH - 3);
+    }
+    screen_print(name);
+}
+
+void draw_managed_log_table(void) {
     for (uint8_t i = 0; i < logDatabase.numberOfFiles; i++) {
-        printf(" #%-2d", (int)i);
-        print(" | ");
-        print_log_level(newLogDatabase[i]);
-        print(" | ");
+        screen_printf(" #%-2d | ", (int)i);
+        if (i == selectedLine) {
+            draw_log_level(newLogDatabase[i], SCREEN_INVERT);
+        } else {
+            draw_log_level(newLogDatabase[i], 0);
+        }
+        screen_print(" | ");
+        draw_log_level(logDatabase.file[i].maxLevel, 0);
+        screen_print(" | ");
         if (logFeatures.useShortNames) {
-            println(logDatabase.file[i].shortName);
+            draw_file_name(logDatabase.file[i].shortName);
         } else {
-            println(logDatabase.file[i].name);
+            draw_file_name(logDatabase.file[i].name);
         }
+        screen_print("\n");
     }
 }
 
-void print_logedit_footer(void) {
-    println("-----------------------------------------------");
+void draw_logedit_footer(void) {
+    screen_print(HORIZONTAL_RULE);
     for (uint8_t i = 0; i < NUMBER_OF_LOG_LEVELS; i++) {
-        print_log_level(i);
-        print(" ");
+        draw_log_level(i, 0);
+        screen_print(" ");
     }
-    println("");
-    println("-----------------------------------------------");
+    screen_print("\n");
+    screen_print(HORIZONTAL_RULE);
 
     // usage instructions
     //! These are disabled to help logedit fit on page in the terminal
-    // println("press f5 to refresh list");
-    // println("press ENTER to save and exit");
-    // println("press ESC to exit without saving");
-    // println("press ctrl+c to terminate logedit");
+    // screen_print("press f5 to refresh list\n");
+    // screen_print("press ENTER to save and exit\n");
+    // screen_print("press ESC to exit without saving\n");
+    // screen_print("press ctrl+c to terminate logedit\n");
 }
 
+/*  The whole screen is drawn every time something changes, and the screen
+    buffer takes care of only sending the cells that are actually different.
+    Moving the selection sends a couple of dozen bytes instead of the whole
+    table.
+*/
 void draw_logedit(void) {
-    // wipe the screen
-    term_reset_screen();
-    term_cursor_set(0, 0);
-
-    // draw charts and graphs
-    print_logedit_header();
-    print_managed_log_table();
-    print_logedit_footer();
-
-    // set the cursor to the first log level
-    term_cursor_set(0, 0);
-    term_cursor_down(HEADER_HEIGHT);
-    selectedLine = 0;
-    selectedLevel = 0;
-
-    // highlight the first line
-    invert_text_attribute();
-    reprint_line();
-}
-
-/* -------------------------------------------------------------------------- */
+    screen_clear();
 
-void up_one_line(void) {
-    reprint_line();
-    selectedLine--;
-    selectedLevel = newLogDatabase[selectedLine];
-    term_cursor_up(1);
-    invert_text_attribute();
-    reprint_line();
-}
-
-void down_one_line(void) {
-    reprint_line();
-    selectedLine++;
-    selectedLevel = newLogDatabase[selectedLine];
-    term_cursor_down(1);
-    invert_text_attribute();
-    reprint_line();
-}
+    draw_logedit_header();
+    draw_managed_log_table();
+    draw_logedit_footer();
 
-void increase_level(void) {
-    selectedLevel++;
-    newLogDatabase[selectedLine] = selectedLevel;
-    invert_text_attribute();
-    reprint_line();
+    screen_flush();
 }
 
-void decrease_level(void) {
-    selectedLevel--;
-    newLogDatabase[selectedLine] = selectedLevel;
-    invert_text_attribute();
-    reprint_line();
-}
+/* -------------------------------------------------------------------------- */
 
 int8_t logedit_keys(key_t key) {
     switch (key.key) {
@@ -290,22 +470,30 @@ int8_t logedit_keys(key_t key) {
         return 0;
     case UP:
         if (selectedLine > 0) {
-            up_one_line();
+            selectedLine--;
+            selectedLevel = newLogDatabase[selectedLine];
+            draw_logedit();
         }
         return 0;
     case DOWN:
         if (selectedLine < logDatabase.numberOfFiles - 1) {
-            down_one_line();
+            selectedLine++;
+            selectedLevel = newLogDatabase[selectedLine];
+            draw_logedit();
         }
         return 0;
     case LEFT:
         if (selectedLevel > 0) {
-            decrease_level();
+            selectedLevel--;
+            newLogDatabase[selectedLine] = selectedLevel;
+            draw_logedit();
         }
         return 0;
     case RIGHT:
-        if (selectedLevel < 6) { // todo: magic number
-            increase_level();
+        if (selectedLevel < logDatabase.file[selectedLine].maxLevel) {
+            selectedLevel++;
+            newLogDatabase[selectedLine] = selectedLevel;
+            draw_logedit();
         }
         return 0;
     case F1:
@@ -322,15 +510,16 @@ int8_t logedit_keys(key_t key) {
         draw_logedit();
         return 0;
     case F5:
+        screen_invalidate();
         draw_logedit();
         return 0;
     case ENTER:
-        for (uint8_t i = 0; i < MAX_NUMBER_OF_FILES; i++) {
+        for (uint8_t i = 0; i < logDatabase.numberOfFiles; i++) {
             *logDatabase.file[i].levelPtr = newLogDatabase[i];
         }
         return -1;
     case ESCAPE:
-        for (uint8_t i = 0; i < MAX_NUMBER_OF_FILES; i++) {
+        for (uint8_t i = 0; i < logDatabase.numberOfFiles; i++) {
             *logDatabase.file[i].levelPtr = oldLogDatabase[i];
         }
         return -1;
@@ -354,19 +543,23 @@ int8_t logedit_callback(char currentChar) {
 // setup
 void logedit(int argc, char **argv) {
     // make a backup of the existing log database
-    for (uint8_t i = 0; i < MAX_NUMBER_OF_FILES; i++) {
+    for (uint8_t i = 0; i < logDatabase.numberOfFiles; i++) {
         oldLogDatabase[i] = *logDatabase.file[i].levelPtr;
     }
     // use that backup to initialize our new working copy
-    for (uint8_t i = 0; i < MAX_NUMBER_OF_FILES; i++) {
+    for (uint8_t i = 0; i < logDatabase.numberOfFiles; i++) {
         newLogDatabase[i] = oldLogDatabase[i];
     }
     // set the "real" log data to all silent
-    for (uint8_t i = 0; i < MAX_NUMBER_OF_FILES; i++) {
+    for (uint8_t i = 0; i < logDatabase.numberOfFiles; i++) {
         *logDatabase.file[i].levelPtr = L_SILENT;
     }
 
+    selectedLine = 0;
+    selectedLevel = newLogDatabase[0];
+
     term_hide_cursor();
+    screen_init();
     draw_logedit();
 
     shell_register_callback(logedit_callback);
@@ -4,6 +4,7 @@
 #include <stdbool.h>
 #include <stdint.h>
 
+#include "channel_mux.h"
 #include "serial_port.h"
 
 /* ************************************************************************** */
@@ -22,83 +23,141 @@ typedef enum {
 } log_levels_t;
 
 /* ************************************************************************** */
+// returned instead of a fileID when there's no such file
+#define LOG_NO_FILE 0xff
+
 /*  log_register__() registers a file with the log manager
 
     Registering a file allows its log level to be edited at runtime using the
     logedit shell program.
+
+    Returns the file's ID. Registering the same file again just returns the
+    same ID. If there's no room left, a warning is printed and LOG_NO_FILE is
+    returned.
 */
 //! Do not call directly. Use log_register() wrapper macro defined below.
-extern void log_register__(const char *name, uint8_t *level);
+extern uint8_t log_register__(const char *name, uint8_t *level,
+                              uint8_t maxLevel);
 
 /*  log_header() prints nicely formatted log message headers
 
     <timestamp> <LEVEL> <path/to/source/file/c:line#>: [custom message]
     example:
     60902l TRACE src/tuning.c:500: full_tune
+
+    'levelPtr' identifies the file's registration record, which already knows
+    the file's short name. The level names are prebuilt with their colors, and
+    the numbers are formatted without any division, so a header is just a
+    handful of string writes.
+
+    When the UART is shared, log messages are sent on their own channel (see
+    channel_mux.h). The header switches to it, and returns the channel that
+    was selected before, which the caller hands back to log_footer().
+*/
+//! Do not call directly. Use LOG_XXXX() wrapper macros defined below.
+extern channel_t print_log_header(uint8_t msgLevel, uint8_t *levelPtr,
+                                  const char *file, int line);
+
+/*  log_footer() finishes a log message, and switches back to 'previous'
+
+    The previous channel lives in the log site, not in a static, so a log
+    message printed from inside another one's BLOCK can't lose track of it.
 */
 //! Do not call directly. Use LOG_XXXX() wrapper macros defined below.
-extern void print_log_header(uint8_t msgLevel, const char *file, int line);
+extern void print_log_footer(channel_t previous);
 
 /* ************************************************************************** */
 
+/*  LOG_LEVEL_MAX is a compile time ceiling on a file's log level
+
+    Every log site above the ceiling is compiled out completely, so it costs
+    no flash and no runtime comparison. Everything at or below the ceiling can
+    still be changed at runtime with logedit, which won't go past it.
+
+    A file sets its ceiling before including anything:
+        #define LOG_LEVEL_MAX L_INFO
+        #include "os/logging.h"
+
+    The default is L_TRACE, which keeps every site. A project can pass
+    -DLOG_LEVEL_MAX=L_WARN to change the default for every file, in which case
+    a file that wants something else has to #undef it first.
+*/
+#ifndef LOG_LEVEL_MAX
+#define LOG_LEVEL_MAX L_TRACE
+#endif
+
+/* -------------------------------------------------------------------------- */
+
 #ifdef LOGGING_ENABLED
 
-#define log_register() log_register__(__FILE__, &LOG_LEVEL)
+#define log_register() log_register__(__FILE__, &LOG_LEVEL, LOG_LEVEL_MAX)
 
 #define ON_TRACE(BLOCK)                                                        \
-    if (L_TRACE <= LOG_LEVEL) {                                                \
+    if (L_TRACE <= LOG_LEVEL_MAX && L_TRACE <= LOG_LEVEL) {                    \
         BLOCK                                                                  \
     }
 #define ON_DEBUG(BLOCK)                                                        \
-    if (L_DEBUG <= LOG_LEVEL) {                                                \
+    if (L_DEBUG <= LOG_LEVEL_MAX && L_DEBUG <= LOG_LEVEL) {                    \
         BLOCK                                                                  \
     }
 #define ON_INFO(BLOCK)                                                         \
-    if (L_INFO <= LOG_LEVEL) {                                                 \
+    if (L_INFO <= LOG_LEVEL_MAX && L_INFO <= LOG_LEVEL) {                      \
         BLOCK                                                                  \
     }
 #define ON_WARN(BLOCK)                                                         \
-    if (L_WARN <= LOG_LEVEL) {                                                 \
+    if (L_WARN <= LOG_LEVEL_MAX && L_WARN <= LOG_LEVEL) {                      \
         BLOCK                                                                  \
     }
 #define ON_ERROR(BLOCK)                                                        \
-    if (L_ERROR <= LOG_LEVEL) {                                                \
+    if (L_ERROR <= LOG_LEVEL_MAX && L_ERROR <= LOG_LEVEL) {                    \
         BLOCK                                                                  \
     }
 #define ON_FATAL(BLOCK)                                                        \
-    if (L_FATAL <= LOG_LEVEL) {                                                \
+    if (L_FATAL <= LOG_LEVEL_MAX && L_FATAL <= LOG_LEVEL) {                    \
         BLOCK                                                                  \
     }
 
 #define LOG_TRACE(BLOCK)                                                       \
-    if (L_TRACE <= LOG_LEVEL) {                                                \
-        print_log_header(L_TRACE, __FILE__, __LINE__);                         \
+    if (L_TRACE <= LOG_LEVEL_MAX && L_TRACE <= LOG_LEVEL) {                    \
+        channel_t channelBeforeLog =                                           \
+            print_log_header(L_TRACE, &LOG_LEVEL, __FILE__, __LINE__);         \
         BLOCK                                                                  \
+        print_log_footer(channelBeforeLog);                                    \
     }
 #define LOG_DEBUG(BLOCK)                                                       \
-    if (L_DEBUG <= LOG_LEVEL) {                                                \
-        print_log_header(L_DEBUG, __FILE__, __LINE__);                         \
+    if (L_DEBUG <= LOG_LEVEL_MAX && L_DEBUG <= LOG_LEVEL) {                    \
+        channel_t channelBeforeLog =                                           \
+            print_log_header(L_DEBUG, &LOG_LEVEL, __FILE__, __LINE__);         \
         BLOCK                                                                  \
+        print_log_footer(channelBeforeLog);                                    \
     }
 #define LOG_INFO(BLOCK)                                                        \
-    if (L_INFO <= LOG_LEVEL) {                                                 \
-        print_log_header(L_INFO, __FILE__, __LINE__);                          \
+    if (L_INFO <= LOG_LEVEL_MAX && L_INFO <= LOG_LEVEL) {                      \
+        channel_t channelBeforeLog =                                           \
+            print_log_header(L_INFO, &LOG_LEVEL, __FILE__, __LINE__);          \
         BLOCK                                                                  \
+        print_log_footer(channelBeforeLog);                                    \
     }
 #define LOG_WARN(BLOCK)                                                        \
-    if (L_WARN <= LOG_LEVEL) {                                                 \
-        print_log_header(L_WARN, __FILE__, __LINE__);                          \
+    if (L_WARN <= LOG_LEVEL_MAX && L_WARN <= LOG_LEVEL) {                      \
+        channel_t channelBeforeLog =                                           \
+            print_log_header(L_WARN, &LOG_LEVEL, __FILE__, __LINE__);          \
         BLOCK                                                                  \
+        print_log_footer(channelBeforeLog);                                    \
     }
 #define LOG_ERROR(BLOCK)                                                       \
-    if (L_ERROR <= LOG_LEVEL) {                                                \
-        print_log_header(L_ERROR, __FILE__, __LINE__);                         \
+    if (L_ERROR <= LOG_LEVEL_MAX && L_ERROR <= LOG_LEVEL) {                    \
+        channel_t channelBeforeLog =                                           \
+            print_log_header(L_ERROR, &LOG_LEVEL, __FILE__, __LINE__);         \
         BLOCK                                                                  \
+        print_log_footer(channelBeforeLog);                                    \
     }
 #define LOG_FATAL(BLOCK)                                                       \
-    if (L_FATAL <= LOG_LEVEL) {                                                \
-        print_log_header(L_FATAL, __FILE__, __LINE__);                         \
+    if (L_FATAL <= LOG_LEVEL_MAX && L_FATAL <= LOG_LEVEL) {                    \
+        channel_t channelBeforeLog =                                           \
+            print_log_header(L_FATAL, &LOG_LEVEL, __FILE__, __LINE__);         \
         BLOCK                                                                  \
+        print_log_footer(channelBeforeLog);                                    \
     }
 
 #else // #ifdef LOGGING_ENABLED
@@ -130,6 +189,7 @@ typedef struct {
     const char *name;
     uint8_t *levelPtr;
     const char *shortName;
+    uint8_t maxLevel; // the file's LOG_LEVEL_MAX
 } log_level_t;
 
 /*  log_settings_t
@@ -166,15 +226,51 @@ typedef struct {
     } log_settings_t;
 */
 
+/*  log_database_t
+
+    Files are stored in the order they were registered, and their index in
+    file[] is their fileID. To find a file by name without comparing against
+    every single one, there's also a small open addressed hash table: each
+    slot holds a fileID + 1, or 0 if it's empty, and a file's first choice of
+    slot comes from a hash of its short name. A collision just moves on to the
+    next slot. A second table works the same way, but it's keyed on the address
+    of the file's LOG_LEVEL, which is all that a log header has to go on.
+
+    The table always has at least twice as many slots as there are files, so
+    it never gets more than half full and a lookup almost always lands on the
+    right file, or an empty slot, on its first or second try.
+
+    A project can override MAX_NUMBER_OF_FILES, up to 127.
+*/
+
+#ifndef MAX_NUMBER_OF_FILES
 #ifdef LOGGING_ENABLED
 #define MAX_NUMBER_OF_FILES 20
 #else
 #define MAX_NUMBER_OF_FILES 1
 #endif
+#endif
+
+// the smallest power of two that's at least twice MAX_NUMBER_OF_FILES
+#if MAX_NUMBER_OF_FILES <= 8
+#define LOG_REGISTRY_SIZE 16
+#elif MAX_NUMBER_OF_FILES <= 16
+#define LOG_REGISTRY_SIZE 32
+#elif MAX_NUMBER_OF_FILES <= 32
+#define LOG_REGISTRY_SIZE 64
+#elif MAX_NUMBER_OF_FILES <= 64
+#define LOG_REGISTRY_SIZE 128
+#elif MAX_NUMBER_OF_FILES <= 127
+#define LOG_REGISTRY_SIZE 256
+#else
+#error "MAX_NUMBER_OF_FILES can't be more than 127"
+#endif
 
 typedef struct {
     log_level_t file[MAX_NUMBER_OF_FILES];
     uint8_t numberOfFiles;
+    uint8_t slot[LOG_REGISTRY_SIZE];      // by short name
+    uint8_t levelSlot[LOG_REGISTRY_SIZE]; // by levelPtr
 } log_database_t;
 
 extern log_database_t logDatabase;
@@ -194,19 +290,64 @@ extern log_features_t logFeatures;
 // setup
 extern void logging_init(void);
 
-// modify a the log level for the given fileID
-extern void log_level_edit(uint8_t fileID, uint8_t level);
+// returns the ID of a file, or LOG_NO_FILE if it isn't registered
+// 'filename' can be a short name, like "records.c", or a full path
+extern uint8_t look_up_file_id(const char *filename);
+
+// modify the log level for the given fileID
+// returns false if there's no such file
+extern bool log_level_edit(uint8_t fileID, uint8_t level);
 
-// modify a the log level for the given file shortname
-extern void set_log_level(const char *filename, uint8_t level);
+// modify the log level for the given file, see look_up_file_id()
+// returns false if there's no such file
+extern bool set_log_level(const char *filename, uint8_t level);
 
 // future api
-extern void push_log_level(const char *filename, uint8_t level);
-extern void pop_log_level(const char *filename);
+extern bool push_log_level(const char *filename, uint8_t level);
+extern bool pop_log_level(const char *filename);
 
 // print the specified log level
 extern void print_log_level(uint8_t level);
 
 /* ************************************************************************** */
+/*  Log site report
+
+    Every build writes log_site_report.txt, next to this file, with the number
+    of log sites each file kept under its LOG_LEVEL_MAX. Only a ceiling that's
+    #defined in the file itself is noticed, not one that comes from the
+    command line.
+*/
+
+/* [[[cog
+import re
+from pathlib import Path
+
+levels = ['SILENT', 'FATAL', 'ERROR', 'WARN', 'INFO', 'DEBUG', 'TRACE']
+site = re.compile(r'\b(?:LOG|ON|DLOG)_(TRACE|DEBUG|INFO|WARN|ERROR|FATAL)\(')
+ceiling = re.compile(r'^\s*#\s*define\s+LOG_LEVEL_MAX\s+L_(\w+)', re.M)
+
+rows = []
+for path in sorted(Path('src').rglob('*.c')):
+    text = path.read_text()
+    found = [levels.index(level) for level in site.findall(text)]
+    if not found:
+        continue
+
+    match = ceiling.search(text)
+    maxLevel = match.group(1) if match else 'TRACE'
+    kept = [level for level in found if level <= levels.index(maxLevel)]
+    rows.append((str(path), maxLevel, len(kept), len(found)))
+
+width = max([len(row[0]) for row in rows] + [4])
+report = [f'{"file".ljust(width)}  {"max".ljust(6)}  kept/total']
+for path, maxLevel, kept, total in rows:
+    report.append(f'{path.ljust(width)}  {maxLevel.ljust(6)}  {kept}/{total}')
+report.append(f'{sum(r[2] for r in rows)} of {sum(r[3] for r in rows)} log sites kept')
+
+name = Path(Path(cog.inFile).parent, 'log_site_report.txt')
+name.write_text('\n'.join(report) + '\n')
+
+]]] */
+/* [[[end]]] */
 
 #endif
\ No newline at end of file
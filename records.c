@@ -3,6 +3,7 @@
 #include "os/shell/shell.h"
 #include "os/shell/shell_command_utils.h"
 #include "os/shell/shell_keys.h"
+#include "os/shell/shell_pager.h"
 #include "os/shell/shell_utils.h"
 #include "peripherals/nonvolatile_memory.h"
 static uint8_t LOG_LEVEL = L_SILENT;
@@ -28,17 +29,28 @@ void _print_record(uint8_t recordID) {
            records[recordID].length, records[recordID].overprovision);
 }
 
-void _print_records(void) {
-    for (uint8_t i = 0; i < numOfRecords; i++) {
-        _print_record(i);
+// one record per row, then a blank line
+static bool print_records_row(uint16_t row) {
+    if (row < numOfRecords) {
+        _print_record(row);
+        return true;
+    }
+    if (row == numOfRecords) {
+        printf("\r\n");
+        return true;
     }
-    printf("\r\n");
+    return false;
+}
+
+void _print_records(void) {
+    shell_page(print_records_row); //
 }
 
 /* ************************************************************************** */
 
-// forward declaration
-extern void sh_records(int argc, char **argv);
+#ifdef DEVELOPMENT
+SHELL_COMMAND(sh_records, "records");
+#endif
 
 void records_init(uint16_t minAddress, uint16_t maxAddress) {
     // clear all the chunk data
@@ -54,10 +66,6 @@ void records_init(uint16_t minAddress, uint16_t maxAddress) {
     // TODO: implement maxAddress
 
     log_register();
-
-#ifdef DEVELOPMENT
-    shell_register_command(sh_records, "records");
-#endif
 }
 
 uint8_t create_new_record(uint16_t recordSize, uint16_t overprovisionFactor,
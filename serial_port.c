@@ -1,12 +1,20 @@
 #include "serial_port.h"
+#include "channel_mux.h"
 #include "peripherals/uart.h"
+#include <stddef.h>
+#include <stdint.h>
 
 /* ************************************************************************** */
 
 EMPTY_UART_INTERFACE(uart);
 
+static tx_space_function_t txSpace = NULL;
+
 void serial_port_init(uart_config_t *config) {
-    uart = UART_init(config); //
+    uart = UART_init(config);
+
+    // the driver knows how full its TX buffer is, see serial_port.h
+    txSpace = uart.tx_space;
 }
 
 /* -------------------------------------------------------------------------- */
@@ -29,17 +37,59 @@ GETCH_RETURN_TYPE getch(void) {
     return uart.rx_char(); //
 }
 
+/* -------------------------------------------------------------------------- */
+
+static console_capture_t capture = NULL;
+
+void serial_port_capture(console_capture_t newCapture) {
+    capture = newCapture; //
+}
+
+void serial_port_set_tx_space(tx_space_function_t function) {
+    txSpace = function; //
+}
+
+// Returns the number of bytes that can be printed without waiting
+uint16_t serial_port_tx_space(void) {
+    // a capture takes everything it's given
+    if (capture) {
+        return UINT16_MAX;
+    }
+
+    // the driver can't tell us, so printing anything might block
+    if (!txSpace) {
+        return UINT16_MAX;
+    }
+
+    return txSpace();
+}
+
+/* -------------------------------------------------------------------------- */
+
 // Print a string
 void print(const char *string) {
     /*  Wrap UART_TX_STRING() to provide both a portability layer, and to keep
         the user from having to add the termination character every time they
         print
     */
+    if (capture) {
+        capture(string);
+        return;
+    }
+
+    channel_mux_tag_output();
     uart.tx_string(string, '\0');
 }
 
 // Print a string and append a newline
 void println(const char *string) {
+    if (capture) {
+        capture(string);
+        capture("\r\n");
+        return;
+    }
+
+    channel_mux_tag_output();
     uart.tx_string(string, '\0');
     print("\r\n");
 }
\ No newline at end of file
@@ -4,6 +4,7 @@
 /* ************************************************************************** */
 
 #include "peripherals/uart.h"
+#include <stdint.h>
 #include <stdio.h>
 
 /* ************************************************************************** */
@@ -33,6 +34,41 @@ extern void print(const char *string);
 // Print a string and append a newline
 extern void println(const char *string);
 
+/* -------------------------------------------------------------------------- */
+
+// a function that returns how many bytes the UART can take without blocking
+typedef uint16_t (*tx_space_function_t)(void);
+
+/*  serial_port_init() uses the UART driver's tx_space() function, which
+    returns the number of free bytes in its TX buffer, so the shell pager,
+    deferred logs, and json_print_step() pace themselves without any setup.
+
+    The application can replace it, for example if the UART is being shared
+    with something else that also needs room in the buffer:
+
+        serial_port_set_tx_space(my_tx_space);
+
+    If the driver doesn't provide tx_space() and nothing else is set,
+    serial_port_tx_space() returns UINT16_MAX, so everything that paces itself
+    with it prints everything at once, and blocks just like print() does.
+*/
+extern void serial_port_set_tx_space(tx_space_function_t function);
+
+// Returns the number of bytes that can be printed without waiting
+extern uint16_t serial_port_tx_space(void);
+
+/* -------------------------------------------------------------------------- */
+
+// a function that accepts console output instead of the UART
+typedef void (*console_capture_t)(const char *string);
+
+/*  Redirect everything printed to the console, including printf() and
+    sh_print(), to 'capture' instead of the UART. Pass NULL to go back to the
+    UART. This lets something like judi_shell.c run a shell command and keep
+    its output.
+*/
+extern void serial_port_capture(console_capture_t capture);
+
 /* ************************************************************************** */
 
 #endif // _SERIAL_PORT_H_
\ No newline at end of file
@@ -69,14 +69,6 @@ void shell_init(void) {
     // shell history
     shell_history_init();
 
-    // Register the builtins
-    shell_register_command(sh_help, "help");
-    shell_register_command(sh_clear, "clear");
-    shell_register_command(sh_reboot, "reboot");
-    shell_register_command(sh_test, "test");
-    shell_register_command(sh_version, "version");
-    shell_register_command(sh_colors, "colors");
-
     // draw a prompt so the user know we're alive
     sh_println("");
     draw_shell_prompt();
@@ -84,10 +76,75 @@ void shell_init(void) {
 
 /* ************************************************************************** */
 
+/*  TAB completion
+
+    Only the command name is completed, so this does nothing unless the cursor
+    is at the end of the first word. In the middle of a word, the rest of the
+    word would end up after the completion, like "logeditedit". Pressing TAB fills in as much of the command as all
+    the matching commands have in common, plus a space if there's only one.
+    If there's nothing more to fill in, the matching commands are listed.
+*/
+static void complete_command(shell_line_t *line) {
+    for (uint8_t i = 0; i < line->cursor; i++) {
+        if (line->buffer[i] == ' ') {
+            return;
+        }
+    }
+    if (line->cursor < line->length && line->buffer[line->cursor] != ' ') {
+        return;
+    }
+
+    const char *prefix = line->buffer;
+    uint8_t length = line->cursor;
+
+    uint8_t count = count_commands_with_prefix(prefix, length);
+    if (count == 0) {
+        return;
+    }
+
+    // the commands are sorted, so whatever the first and last matches have in
+    // common, every match in between has too
+    const char *firstName = get_command_with_prefix(prefix, length, 0);
+    const char *lastName = get_command_with_prefix(prefix, length, count - 1);
+    uint8_t common = line->cursor;
+    while (firstName[common] && firstName[common] == lastName[common]) {
+        common++;
+    }
+
+    if (common > line->cursor) {
+        for (uint8_t i = line->cursor; i < common; i++) {
+            insert_char_at_cursor(line, firstName[i]);
+        }
+        if (count == 1 && line->cursor == line->length) {
+            insert_char_at_cursor(line, ' ');
+        }
+        return;
+    }
+
+    if (count == 1) {
+        return;
+    }
+
+    // ambiguous, so show the candidates and put the line back
+    sh_println("");
+    for (uint8_t i = 0; i < count; i++) {
+        sh_print(get_command_with_prefix(prefix, length, i));
+        sh_print("  ");
+    }
+    sh_println("");
+    draw_shell_prompt();
+    draw_line(line);
+}
+
+/* -------------------------------------------------------------------------- */
+
 void process_escape_sequence(key_t key) {
     switch (key.key) {
     default: // unrecognized keys don't do anything
         return;
+    case TAB:
+        complete_command(&shell);
+        return;
     case BACKSPACE: // delete one character to the left of the cursor
         if (shell.cursor != 0) {
             move_cursor_left(&shell);
@@ -124,6 +181,9 @@ void process_escape_sequence(key_t key) {
     case DOWN:
         shell_history_show_newer();
         return;
+    case SEARCH:
+        shell_history_search();
+        return;
     case LEFT:
         switch (key.mod) {
         default:
@@ -166,7 +226,7 @@ void process_escape_sequence(key_t key) {
 
 /* -------------------------------------------------------------------------- */
 
-void shell_update(char currentChar) {
+static void process_character(char currentChar) {
     // execute shell callback, if one is registered
     if (shellCallback) {
         int8_t result = shellCallback(currentChar);
@@ -193,4 +253,15 @@ void shell_update(char currentChar) {
         insert_char_at_cursor(&shell, currentChar);
         return;
     }
+}
+
+void shell_update(char currentChar) {
+    // escape sequences are assembled one character at a time
+    process_character(escape_sequence_update(currentChar));
+
+    // ESC followed by a normal key produces two keypresses
+    char leftover = escape_sequence_leftover();
+    if (leftover) {
+        process_character(escape_sequence_update(leftover));
+    }
 }
\ No newline at end of file
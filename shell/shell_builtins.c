@@ -7,15 +7,39 @@
 #include "shell_command_utils.h"
 #include "shell_config.h"
 #include "shell_cursor.h"
+#include "shell_pager.h"
 #include "system.h"
 
 /* ************************************************************************** */
+// the builtins, see shell_command_table.h
+
+SHELL_COMMAND(sh_help, "help");
+SHELL_COMMAND(sh_clear, "clear");
+SHELL_COMMAND(sh_reboot, "reboot");
+SHELL_COMMAND(sh_test, "test");
+SHELL_COMMAND(sh_version, "version");
+SHELL_COMMAND(sh_colors, "colors");
+
+/* ************************************************************************** */
+
+// a separator, every registered command, and another separator
+static bool print_help_row(uint16_t row) {
+    uint8_t count = count_commands_with_prefix("", 0);
+
+    if (row == 0 || row == count + 1) {
+        sh_println("-----------------------------------------------");
+        return true;
+    }
+    if (row <= count) {
+        sh_println(get_command_with_prefix("", 0, row - 1));
+        return true;
+    }
+    return false;
+}
 
 // prints all registered commands
 void sh_help(int argc, char **argv) {
-    sh_println("-----------------------------------------------");
-    print_command_list();
-    sh_println("-----------------------------------------------");
+    shell_page(print_help_row); //
 }
 
 /* -------------------------------------------------------------------------- */
@@ -111,8 +135,7 @@ void sh_test(int argc, char **argv) {
 
 void sh_version(int argc, char **argv) {
     if ((argc == 2) && (!strcmp(argv[1], "-j"))) {
-        json_print(print, deviceInfo);
-        println("");
+        shell_page_json(deviceInfo);
         return;
     }
 
@@ -1,6 +1,8 @@
 #include "shell_command_processor.h"
 #include "shell.h"
+#include "shell_command_table.h"
 #include "shell_config.h"
+#include <stddef.h>
 #include <string.h>
 
 /* ************************************************************************** */
@@ -15,35 +17,190 @@ shell_args_t new_args(void) {
 
 /* ************************************************************************** */
 
+/*  The RAM command list is kept in alphabetical order. Registration is a little
+    slower, because a new command has to be inserted in the right place, but
+    registration only happens once at startup, and every command lookup after
+    that can use a binary search instead of comparing against every single
+    command in the list.
+
+    Keeping the list sorted also means that all the commands that start with
+    the same prefix are right next to each other, which is what makes TAB
+    completion cheap.
+*/
+
 shell_command_t commandList[MAXIMUM_NUM_OF_SHELL_COMMANDS] = {0};
 uint8_t number_of_commands = 0;
 
 void shell_register_command(command_function_t function, const char *command) {
-    commandList[number_of_commands].function = function;
-    commandList[number_of_commands].command = command;
+    if (number_of_commands >= MAXIMUM_NUM_OF_SHELL_COMMANDS) {
+        return;
+    }
+
+    // shift everything that sorts after the new command to the right
+    uint8_t i = number_of_commands;
+    while (i > 0 && strcmp(command, commandList[i - 1].command) < 0) {
+        commandList[i] = commandList[i - 1];
+        i--;
+    }
+
+    commandList[i].function = function;
+    commandList[i].command = command;
     number_of_commands++;
 }
 
+/* ************************************************************************** */
+/*  There are two sorted lists of commands: the const shellCommandTable[] that
+    was generated at build time, and the RAM commandList[] that's filled in by
+    shell_register_command(). Anything that needs to see every command in
+    order walks both lists at the same time, the same way you'd merge two
+    sorted lists.
+*/
+
+typedef struct {
+    uint8_t rom;
+    uint8_t romEnd;
+    uint8_t ram;
+    uint8_t ramEnd;
+} command_range_t;
+
+// returns the next command in the range, in alphabetical order
+static const shell_command_t *next_command(command_range_t *range) {
+    const shell_command_t *rom = NULL;
+    const shell_command_t *ram = NULL;
+
+    if (range->rom < range->romEnd) {
+        rom = &shellCommandTable[range->rom];
+    }
+    if (range->ram < range->ramEnd) {
+        ram = &commandList[range->ram];
+    }
+
+    if (rom && (!ram || strcmp(rom->command, ram->command) <= 0)) {
+        range->rom++;
+        return rom;
+    }
+    if (ram) {
+        range->ram++;
+        return ram;
+    }
+    return NULL;
+}
+
+// returns the index of the first command that doesn't sort before 'prefix'
+static uint8_t lower_bound(const shell_command_t *list, uint8_t length,
+                           const char *prefix, uint8_t prefixLength) {
+    uint8_t low = 0;
+    uint8_t high = length;
+
+    while (low < high) {
+        uint8_t middle = (low + high) / 2;
+
+        if (strncmp(list[middle].command, prefix, prefixLength) < 0) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return low;
+}
+
+// returns the index just past the last command that starts with 'prefix'
+static uint8_t prefix_end(const shell_command_t *list, uint8_t length,
+                          uint8_t start, const char *prefix,
+                          uint8_t prefixLength) {
+    while (start < length) {
+        if (strncmp(list[start].command, prefix, prefixLength)) {
+            break;
+        }
+        start++;
+    }
+    return start;
+}
+
+static command_range_t find_prefix_range(const char *prefix, uint8_t length) {
+    command_range_t range;
+
+    range.rom = lower_bound(shellCommandTable, shellCommandTableLength, prefix,
+                            length);
+    range.romEnd = prefix_end(shellCommandTable, shellCommandTableLength,
+                              range.rom, prefix, length);
+    range.ram = lower_bound(commandList, number_of_commands, prefix, length);
+    range.ramEnd = prefix_end(commandList, number_of_commands, range.ram,
+                              prefix, length);
+
+    return range;
+}
+
+/* -------------------------------------------------------------------------- */
+
 // Print all registered shell commands
 void print_command_list(void) {
-    for (uint8_t i = 0; i < number_of_commands; i++) {
-        sh_println(commandList[i].command);
+    command_range_t range = {0, shellCommandTableLength, 0, number_of_commands};
+    const shell_command_t *command;
+
+    while ((command = next_command(&range))) {
+        sh_println(command->command);
+    }
+}
+
+uint8_t count_commands_with_prefix(const char *prefix, uint8_t length) {
+    command_range_t range = find_prefix_range(prefix, length);
+
+    return (range.romEnd - range.rom) + (range.ramEnd - range.ram);
+}
+
+const char *get_command_with_prefix(const char *prefix, uint8_t length,
+                                    uint8_t index) {
+    command_range_t range = find_prefix_range(prefix, length);
+    const shell_command_t *command;
+
+    do {
+        command = next_command(&range);
+    } while (command && index--);
+
+    if (!command) {
+        return NULL;
     }
+    return command->command;
 }
 
 /* ************************************************************************** */
 
-// returns the index in list whose command matches the given string
-int8_t find_command_in_list(char *string) {
-    for (uint8_t i = 0; i < number_of_commands; i++) {
-        // If string matches one on the list
-        if (!strcmp(string, commandList[i].command)) {
-            return i;
+// returns the command in 'list' that matches the given string
+static const shell_command_t *search_list(const shell_command_t *list,
+                                          uint8_t length, const char *string) {
+    uint8_t low = 0;
+    uint8_t high = length;
+
+    while (low < high) {
+        uint8_t middle = (low + high) / 2;
+        int result = strcmp(string, list[middle].command);
+
+        if (result == 0) {
+            return &list[middle];
+        } else if (result < 0) {
+            high = middle;
+        } else {
+            low = middle + 1;
         }
     }
-    return -1;
+    return NULL;
 }
 
+// returns the command that matches the given string, or NULL
+static const shell_command_t *find_command(const char *string) {
+    const shell_command_t *command;
+
+    command = search_list(shellCommandTable, shellCommandTableLength, string);
+    if (command) {
+        return command;
+    }
+
+    return search_list(commandList, number_of_commands, string);
+}
+
+/* -------------------------------------------------------------------------- */
+
 // parses a line's buffer into a shell_args_t object
 shell_args_t parse_shell_line(shell_line_t *line) {
     shell_args_t args = new_args();
@@ -61,11 +218,11 @@ int8_t process_shell_command(shell_line_t *line) {
     shell_args_t args = parse_shell_line(line);
 
     // figure out which command matches the received string
-    int8_t command = find_command_in_list(args.argv[0]);
+    const shell_command_t *command = find_command(args.argv[0]);
 
     // if we found a valid command, execute it
-    if (command != -1) {
-        commandList[command].function(args.argc, args.argv);
+    if (command) {
+        command->function(args.argc, args.argv);
 
         return 0;
     }
@@ -16,8 +16,15 @@ typedef struct {
     const char *command;         // The command that needs to be typed
 } shell_command_t;
 
+/*  SHELL_COMMAND() marks a function as a shell command that's built into the
+    ROM command table, see shell_command_table.h for details. The marker also
+    declares the function, so it can be used in place of a forward declaration.
+*/
+#define SHELL_COMMAND(FUNCTION, COMMAND)                                       \
+    extern void FUNCTION(int argc, char **argv)
+
 #ifdef LOGGING_ENABLED
-// register a command and associate it with a name
+// register a command at runtime and associate it with a name
 extern void shell_register_command(command_function_t function, const char *command);
 
 #else
@@ -37,6 +44,9 @@ typedef struct {
 
 extern shell_callback_settings_t shellCallbackSettings;
 
+// the callback that's currently running, or NULL
+extern shell_callback_t shellCallback;
+
 extern void shell_register_callback(shell_callback_t callback);
 
 /* ************************************************************************** */
@@ -44,6 +54,15 @@ extern void shell_register_callback(shell_callback_t callback);
 // prints all commands that are registered in the master command list
 extern void print_command_list(void);
 
+// returns the number of commands that start with the first 'length'
+// characters of 'prefix'
+extern uint8_t count_commands_with_prefix(const char *prefix, uint8_t length);
+
+// returns the name of the 'index'th command, in alphabetical order, that starts
+// with the first 'length' characters of 'prefix', or NULL if there isn't one
+extern const char *get_command_with_prefix(const char *prefix, uint8_t length,
+                                           uint8_t index);
+
 /* -------------------------------------------------------------------------- */
 
 typedef struct {
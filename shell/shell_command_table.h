@@ -0,0 +1,147 @@
+#ifndef _SHELL_COMMAND_TABLE_H_
+#define _SHELL_COMMAND_TABLE_H_
+
+#include "shell_command_processor.h"
+#include <stdint.h>
+
+/* ************************************************************************** */
+/*  ROM command table
+
+    Commands that are marked with SHELL_COMMAND() anywhere in the project are
+    collected at build time into shellCommandTable[], a const array that lives
+    in program memory. These commands don't need a shell_register_command()
+    call, they don't use any RAM, and they don't count against
+    MAXIMUM_NUM_OF_SHELL_COMMANDS.
+
+    Example:
+        #ifdef DEVELOPMENT
+        SHELL_COMMAND(sh_records, "records");
+        #endif
+
+    The generator pays attention to any #ifdef, #ifndef, #if, #else, or #elif
+    around the marker, and wraps the table entry in the same conditions. A
+    command that's only compiled in DEVELOPMENT builds will only be in the
+    table in DEVELOPMENT builds.
+
+    A command can be defined more than once under different conditions, like
+    one version in the #if branch and another in the #else. Each one gets its
+    own entry, wrapped in its own conditions.
+
+    Only files that are part of the build are scanned, otherwise the table
+    would refer to functions that never get linked. Every .c file under src/
+    is built unless the configuration's skip_rules in project.yaml leave it
+    out, so the build passes the configuration's name to cog:
+        cog -D configuration=release ...
+
+    The table is sorted by name when it's generated, so it can be searched with
+    a binary search just like the RAM list. shell_register_command() still
+    works for commands that need to be added at runtime.
+*/
+
+/* ************************************************************************** */
+
+// the generated table, sorted by name
+extern const shell_command_t shellCommandTable[];
+extern const uint8_t shellCommandTableLength;
+
+/* [[[cog
+import re
+import yaml
+import codegen as code
+from fnmatch import fnmatch
+from pathlib import Path
+
+marker = re.compile(r'^\s*SHELL_COMMAND\(\s*(\w+)\s*,\s*"([^"]+)"\s*\)')
+directive = re.compile(r'^\s*#\s*(ifdef|ifndef|if|elif|else|endif)\b(.*)')
+
+# every frame is [conditions of earlier branches, condition of this branch]
+def current_conditions(stack):
+    conditions = []
+    for earlier, current in stack:
+        conditions.extend(f'!({c})' for c in earlier)
+        if current:
+            conditions.append(current)
+    return conditions
+
+# every .c file under src/ that the current configuration doesn't skip
+def compiled_sources():
+    rules = []
+    configuration = globals().get('configuration')
+    project = Path('project.yaml')
+    if configuration and project.exists():
+        settings = yaml.safe_load(project.read_text()) or {}
+        rules = (settings.get(configuration) or {}).get('skip_rules') or []
+    for path in sorted(Path('src').rglob('*.c')):
+        if not any(fnmatch(path.as_posix(), rule) for rule in rules):
+            yield path
+
+# keyed by name and conditions, so #if/#else versions of a command both stay
+commands = {}
+for path in compiled_sources():
+    stack = []
+    for line in path.read_text().splitlines():
+        match = directive.match(line)
+        if match:
+            kind = match.group(1)
+            arg = match.group(2).split('//')[0].strip()
+            if kind == 'ifdef':
+                stack.append([[], f'defined({arg})'])
+            elif kind == 'ifndef':
+                stack.append([[], f'!defined({arg})'])
+            elif kind == 'if':
+                stack.append([[], arg])
+            elif kind == 'elif':
+                stack[-1][0].append(stack[-1][1])
+                stack[-1][1] = arg
+            elif kind == 'else':
+                stack[-1][0].append(stack[-1][1])
+                stack[-1][1] = None
+            elif kind == 'endif':
+                stack.pop()
+            continue
+
+        match = marker.match(line)
+        if match:
+            function, name = match.groups()
+            conditions = tuple(current_conditions(stack))
+            commands[(name, conditions)] = function
+
+def guarded(conditions, text):
+    if not conditions:
+        return text
+    return f'#if {" && ".join(conditions)}\n{text}\n#endif'
+
+declarations = []
+entries = []
+for name, conditions in sorted(commands):
+    function = commands[(name, conditions)]
+    declarations.append(guarded(conditions,
+        f'extern void {function}(int argc, char **argv);'))
+    entries.append(guarded(conditions, f'    {{{function}, "{name}"}},'))
+
+# the extra entry keeps the array from being empty
+table = '\n'.join([
+    'const shell_command_t shellCommandTable[] = {',
+    *entries,
+    '    {NULL, NULL},',
+    '};',
+    '',
+    'const uint8_t shellCommandTableLength =',
+    '    (sizeof(shellCommandTable) / sizeof(shell_command_t)) - 1;',
+])
+
+source = code.SourceFile(
+    name = Path(Path(cog.inFile).parent, 'shell_command_table.c'),
+    includes = ['<stddef.h>', '<stdint.h>', '"shell_command_table.h"'],
+    contents = ['#ifdef LOGGING_ENABLED', *declarations, table, '#endif'],
+)
+
+source.write()
+
+cog.outl(f'// {len(commands)} commands in {Path(source.name).name}')
+
+]]] */
+// 14 commands in shell_command_table.c
+/* [[[end]]] */
+
+#endif // _SHELL_COMMAND_TABLE_H_
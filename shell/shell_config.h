@@ -39,19 +39,44 @@
 // Configures the length of the buffer used to process escape sequences
 #define SEQUENCE_BUFFER_LENGTH 10
 
+// How long to wait for the rest of an escape sequence, in mS
+#define ESCAPE_SEQUENCE_TIMEOUT 5
+
 /* -------------------------------------------------------------------------- */
 // Command processing options
 
 // Configures the maximum number of arguments per command tha can be accepted
 #define CONFIG_SHELL_MAX_COMMAND_ARGS 10
 
+/* -------------------------------------------------------------------------- */
+// Output pager options
+
+// The most a single row from a pager's row generator is expected to print. A
+// row isn't started until the TX buffer has at least this much room, so this
+// has to be smaller than the TX buffer.
+#define SHELL_PAGER_ROW_SIZE 64
+
 /* ************************************************************************** */
 // Optional Features
 
 /* -------------------------------------------------------------------------- */
 // Shell history options
 
-// Defines the number of lines stored in the shell history buffer
-#define SHELL_HISTORY_LENGTH 4
+// History is stored in a fixed 256 byte ring, so there's nothing to configure.
+// The number of commands it holds depends on how long they are.
+
+/* -------------------------------------------------------------------------- */
+// Full screen renderer options
+
+// Uncomment to give fullscreen programs a screen buffer, so they only send the
+// cells that changed. Without it, every frame is a full redraw.
+// #define SHELL_SCREEN_ENABLED
+
+// The size of the screen buffer. Each cell costs a little over two bytes of
+// RAM, and anything drawn outside it is clipped. The default is what logedit
+// needs: 48 columns for its widest row, and 8 rows plus one per registered
+// file, with the default MAX_NUMBER_OF_FILES of 20.
+#define SHELL_SCREEN_WIDTH 48
+#define SHELL_SCREEN_HEIGHT 28
 
 #endif
\ No newline at end of file
@@ -10,30 +10,64 @@ void draw_shell_prompt(void) {
 
 /* -------------------------------------------------------------------------- */
 
+/*  Cursor movement
+
+    Every byte we send to the terminal is a byte the user has to wait for, so
+    the line editor tries hard to send as little as possible. The cheapest way
+    to move the cursor depends on how far it's going:
+
+    left:   backspace is one byte, "\033[<n>D" is at least four
+    right:  reprinting the characters we're moving over is one byte each,
+            "\033[<n>C" is at least four
+
+    Moving to an absolute position with "\033[100D" and then moving right is
+    only used by draw_line(), which is redrawing everything anyway.
+*/
+
+// the longest move that's cheaper to do one character at a time
+#define SHORT_MOVE_LENGTH 3
+
+// move the terminal cursor from one spot in the line to another
+static void move_terminal_cursor(shell_line_t *line, uint8_t from, uint8_t to) {
+    if (to < from) {
+        uint8_t distance = from - to;
+        if (distance <= SHORT_MOVE_LENGTH) {
+            while (distance--) {
+                sh_print("\b");
+            }
+        } else {
+            term_cursor_left(distance);
+        }
+    } else if (to > from) {
+        uint8_t distance = to - from;
+        if (distance <= SHORT_MOVE_LENGTH) {
+            while (from < to) {
+                printf("%c", line->buffer[from++]);
+            }
+        } else {
+            term_cursor_right(distance);
+        }
+    }
+}
+
 void move_cursor_left(shell_line_t *line) {
     // don't move left past beginning of line
     if (line->cursor == 0) {
         return;
     }
 
-    // adjust cursor value
+    move_terminal_cursor(line, line->cursor, line->cursor - 1);
     line->cursor--;
-
-    // move cursor
-    term_cursor_left(1);
 }
 
 void move_cursor_right(shell_line_t *line) {
     // don't move right past end of line
-    if (line->cursor == shell.length) {
+    if (line->cursor == line->length) {
         return;
     }
 
-    // adjust cursor value
+    move_terminal_cursor(line, line->cursor, line->cursor + 1);
     line->cursor++;
-
-    // move cursor
-    term_cursor_right(1);
 }
 
 void move_cursor_to(shell_line_t *line, uint8_t position) {
@@ -42,15 +76,7 @@ void move_cursor_to(shell_line_t *line, uint8_t position) {
         position = line->length;
     }
 
-    term_cursor_home();
-    term_cursor_right(SHELL_PROMPT_LENGTH);
-
-    // move the cursor right to the correct spot
-    if (position != 0) {
-        term_cursor_right(position);
-    }
-
-    // adjust cursor value
+    move_terminal_cursor(line, line->cursor, position);
     line->cursor = position;
 }
 
@@ -62,11 +88,11 @@ void draw_line(shell_line_t *line) {
     term_cursor_right(SHELL_PROMPT_LENGTH);
     term_clear_to_right();
 
-    // reprint existing line
+    // reprint existing line, which leaves the cursor at the end
     sh_print(line->buffer);
 
     // restore the cursor's original position
-    move_cursor_to(line, line->cursor);
+    move_terminal_cursor(line, line->length, line->cursor);
 }
 
 void draw_line_from_cursor(shell_line_t *line) {
@@ -76,44 +102,42 @@ void draw_line_from_cursor(shell_line_t *line) {
     sh_print(&line->buffer[line->cursor]);
 
     // restore the cursor's original position
-    move_cursor_to(line, line->cursor);
+    move_terminal_cursor(line, line->length, line->cursor);
 }
 
+/*  Editing in the middle of the line
+
+    Instead of redrawing everything right of the cursor, we let the terminal
+    do the work. ICH ("\033[@") shifts the rest of the line right by one
+    blank, and DCH ("\033[P") deletes the character under the cursor and
+    shifts the rest of the line left. Either way, an edit costs a handful of
+    bytes no matter how long the line is.
+*/
 void insert_char_at_cursor(shell_line_t *line, char currentChar) {
     // return early if the buffer is already full
     if (line->length >= SHELL_MAX_LENGTH - SHELL_PROMPT_LENGTH) {
         return;
     }
 
-    // process is easier if cursor is already at end of line
-    if (line->cursor == line->length) {
-        // print the new char
-        printf("%c", currentChar);
-
-        // add the new char to the buffer
-        line->buffer[line->cursor] = currentChar;
-
-        // update the length and cursor
-        line->length++;
-        line->cursor++;
-
-        // and we're done
-        return;
+    // open up a blank space in the middle of the line
+    if (line->cursor != line->length) {
+        sh_print("\033[@");
     }
 
-    // the cursor won't move, so just update that length
-    line->length++;
+    // print the new char, which moves the cursor right
+    printf("%c", currentChar);
 
     // take everything right of the cursor and shift it right one space
-    for (uint8_t i = line->length; i >= line->cursor; i--) {
-        line->buffer[i + 1] = line->buffer[i];
+    for (uint8_t i = line->length; i > line->cursor; i--) {
+        line->buffer[i] = line->buffer[i - 1];
     }
 
-    // add the new char
+    // add the new char to the buffer
     line->buffer[line->cursor] = currentChar;
 
-    draw_line_from_cursor(line);
-    move_cursor_right(&shell);
+    // update the length and cursor
+    line->length++;
+    line->cursor++;
 }
 
 void remove_char_at_cursor(shell_line_t *line) {
@@ -128,16 +152,11 @@ void remove_char_at_cursor(shell_line_t *line) {
     }
 
     // take everything right of the cursor and shift it left one space
-    uint8_t i = line->cursor;
-    while (line->buffer[i] != 0) {
+    for (uint8_t i = line->cursor; i < line->length; i++) {
         line->buffer[i] = line->buffer[i + 1];
-        i++;
     }
-
-    line->buffer[i - 1] = 0;
-    line->buffer[i] = 0;
-    line->buffer[i + 1] = 0;
     line->length--;
+    line->buffer[line->length] = 0;
 
-    draw_line_from_cursor(line);
-}
\ No newline at end of file
+    sh_print("\033[P");
+}
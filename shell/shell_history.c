@@ -9,6 +9,7 @@ void toggle_history_inspection_mode(void) {}
 void shell_history_push(void) {}
 void shell_history_show_older(void) {}
 void shell_history_show_newer(void) {}
+void shell_history_search(void) {}
 
 #else
 
@@ -16,63 +17,138 @@ void shell_history_show_newer(void) {}
 #include "shell_history.h"
 #include "shell.h"
 #include "shell_cursor.h"
+#include "shell_pager.h"
+#include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <string.h>
 
 /* ************************************************************************** */
 
-// this is disgusting. Thank you pic18 paged memory...
-#define HISTORY_LIST                                                           \
-    X(0)                                                                       \
-    X(1)                                                                       \
-    X(2)                                                                       \
-    X(3)                                                                       \
-    // X(4)                                                                       \
-    // X(5)                                                                       \
-    // X(6)                                                                       \
-    // X(7)                                                                       \
-    // X(8)                                                                       \
-    // X(9)                                                                       \
-    // X(10)                                                                      \
-    // X(11)                                                                      \
-    // X(12)                                                                      \
-    // X(13)                                                                      \
-    // X(14)                                                                      \
-    // X(15)
-
-#define X(NAME) shell_line_t history_##NAME;
-HISTORY_LIST
-#undef X
+/*  History storage
 
-/* -------------------------------------------------------------------------- */
+    History used to be an array of full shell_line_t's, which cost 82 bytes
+    per entry no matter how short the command was. Paged memory made that
+    even worse, so it only held four commands.
+
+    Now every entry is stored in a single 256 byte ring, as a length byte
+    followed by the characters of the command:
+
+        [4]help[7]records[3]led ...
+        ^tail                   ^head
+
+    New entries are added at the head, and the oldest entries are evicted
+    from the tail to make room. Because the ring is exactly 256 bytes long,
+    every index is a uint8_t and wraps around all by itself. A typical command
+    is well under 16 characters, so the same RAM holds many times more
+    commands than it used to.
+
+    Entries are identified by their age: 1 is the newest, and history.count
+    is the oldest. Finding an entry means walking forward from the tail, which
+    is plenty fast for the number of entries that fit.
+
+    The ring is an object of its own. A PIC18 bank is 256 bytes, so the ring
+    fills one completely, and anything declared in the same object would push
+    it across a bank boundary, which XC8 can't allocate. The indexes and the
+    saved line live in 'history' instead, which can go in any other bank.
+*/
+
+#define RING_SIZE 256
+
+static char historyRing[RING_SIZE];
 
 typedef struct {
-    shell_line_t *line[SHELL_HISTORY_LENGTH];
+    uint8_t tail;  // the length byte of the oldest entry
+    uint8_t head;  // where the next entry will go
+    uint8_t count; // the number of entries
     shell_line_t tempLine;
-    uint8_t head;
     uint8_t pointer;
-    uint8_t length;
     unsigned historyMode : 1;
     unsigned historyInspectionMode : 1;
 } shell_history_t;
 
 shell_history_t history;
 
-// clear a line in the shell history
-static void clear_history_line(uint8_t line) {
-    memset(history.line[line], 0, sizeof(shell_line_t));
+/* -------------------------------------------------------------------------- */
+
+// the next entry after the one at 'index'
+#define next_entry(index) (uint8_t)((index) + historyRing[index] + 1)
+
+// the number of bytes currently in use. The ring is never allowed to fill up
+// completely, so head == tail always means it's empty.
+#define bytes_used() (uint8_t)(history.head - history.tail)
+
+// find the index of the entry that's 'age' entries old
+static uint8_t find_entry(uint8_t age) {
+    uint8_t index = history.tail;
+
+    for (uint8_t i = history.count; i > age; i--) {
+        index = next_entry(index);
+    }
+
+    return index;
 }
 
-void shell_history_wipe(void) {
-    for (uint8_t i = 0; i < SHELL_HISTORY_LENGTH; i++) {
-        clear_history_line(i);
+// does the entry at 'index' start with the first 'length' chars of 'string'?
+static bool entry_starts_with(uint8_t index, const char *string,
+                              uint8_t length) {
+    if (historyRing[index] < length) {
+        return false;
     }
 
+    for (uint8_t i = 0; i < length; i++) {
+        if (historyRing[++index] != string[i]) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// remove the entry at 'index' by sliding everything older forward over it
+static void remove_entry(uint8_t index) {
+    uint8_t size = historyRing[index] + 1;
+    uint8_t from = index;
+    uint8_t to = index + size;
+
+    while (from != history.tail) {
+        historyRing[--to] = historyRing[--from];
+    }
+
+    history.tail += size;
+    history.count--;
+}
+
+// copy an entry into the shell's line buffer
+static void load_entry(uint8_t age) {
+    uint8_t index = find_entry(age);
+    uint8_t length = historyRing[index];
+
+    shell_reset_line(shell);
+    for (uint8_t i = 0; i < length; i++) {
+        shell.buffer[i] = historyRing[++index];
+    }
+    shell.length = length;
+    shell.cursor = length;
+}
+
+// save the line being edited before we start replacing it with history
+static void enter_history_mode(void) {
+    if (history.historyMode == 0) {
+        memcpy(&history.tempLine, &shell, sizeof(shell_line_t));
+        history.historyMode = 1;
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+
+void shell_history_wipe(void) {
     shell_reset_line(history.tempLine);
 
+    history.tail = 0;
     history.head = 0;
+    history.count = 0;
     history.pointer = 0;
-    history.length = 0;
     history.historyMode = 0;
     history.historyInspectionMode = 0;
 }
@@ -80,12 +156,7 @@ void shell_history_wipe(void) {
 /* ************************************************************************** */
 
 void shell_history_init(void) {
-    // initialize history array with pointers to shell_line_t's
-#define X(NAME) history.line[NAME] = &history_##NAME;
-    HISTORY_LIST
-#undef X
-
-    shell_history_wipe();
+    shell_history_wipe(); //
 }
 
 void toggle_history_inspection_mode(void) {
@@ -98,34 +169,84 @@ void toggle_history_inspection_mode(void) {
     draw_shell_prompt();
 }
 
-void inspect_shell_history(void) {
-    sh_println("");
-    sh_println("-----------------------------------------------");
-    sh_println("Printing shell history:");
-    printf("History currently has %d entries.\r\n", history.length);
-    printf("temp slot: %s\r\n", history.tempLine.buffer);
+/*  History inspection
 
-    for (int8_t i = history.length; i >= 0; i--) {
-        uint8_t line = (history.head + i - 1) % SHELL_HISTORY_LENGTH;
+    The dump goes through the pager, one row per call, so a full ring doesn't
+    stall everything else while it prints. The rows are:
+        the header, one row for each entry from oldest to newest, the footer
+*/
 
-        printf("slot #%d: %s", i, history.line[line]->buffer);
-        if (i == history.pointer) {
+#define INSPECTION_HEADER_ROWS 5
+#define INSPECTION_FOOTER_ROWS 3
+
+static bool print_inspection_row(uint16_t row) {
+    switch (row) {
+    case 0:
+        sh_println("");
+        return true;
+    case 1:
+        sh_println("-----------------------------------------------");
+        return true;
+    case 2:
+        sh_println("Printing shell history:");
+        return true;
+    case 3:
+        printf("History currently has %d entries, using %d bytes.\r\n",
+               history.count, bytes_used());
+        return true;
+    case 4:
+        printf("temp slot: %s\r\n", history.tempLine.buffer);
+        return true;
+    }
+
+    row -= INSPECTION_HEADER_ROWS;
+    if (row < history.count) {
+        uint8_t age = history.count - row;
+        uint8_t index = find_entry(age);
+
+        printf("slot #%d: ", age);
+        for (uint8_t i = 1; i <= historyRing[index]; i++) {
+            printf("%c", historyRing[(uint8_t)(index + i)]);
+        }
+        if (age == history.pointer) {
             sh_print(" <--");
         }
         sh_println("");
+        return true;
     }
 
-    printf("current line: %s\r\n", &shell.buffer);
-    sh_println("-----------------------------------------------");
-    sh_println("");
+    switch (row - history.count) {
+    case 0:
+        printf("current line: %s\r\n", shell.buffer);
+        return true;
+    case 1:
+        sh_println("-----------------------------------------------");
+        return true;
+    case 2:
+        sh_println("");
+        return true;
+    }
+    return false;
 }
 
-/* -------------------------------------------------------------------------- */
-/*
+// returns true if the pager is still printing
+bool inspect_shell_history(void) {
+    return shell_page(print_inspection_row); //
+}
 
-    history.pointer is higher the further into the past we got
+// draw the line, after a dump of the history if we're inspecting it
+static void redraw_line(void) {
+    // the pager puts the line back when it's done
+    if (history.historyInspectionMode == 1 && inspect_shell_history()) {
+        return;
+    }
+    draw_line(&shell);
+}
 
-    history.pointer is used as an offset from history.head
+/* -------------------------------------------------------------------------- */
+/*
+    history.pointer is the age of the entry being shown, or 0 for the line
+    that was being edited before we started looking at history.
 */
 
 // push the current line onto the history buffer
@@ -135,60 +256,54 @@ void shell_history_push(void) {
     history.pointer = 0;
     history.historyMode = 0;
 
-    // don't save if the current line matches the most recent history entry
-    if (strcmp((const char *)history.line[history.head], &shell.buffer[0]) ==
-        0) {
-        return;
+    // if this command is already in the history, move it to the front instead
+    // of keeping two copies
+    uint8_t index = history.tail;
+    for (uint8_t i = 0; i < history.count; i++) {
+        if (historyRing[index] == shell.length &&
+            entry_starts_with(index, shell.buffer, shell.length)) {
+            remove_entry(index);
+            break;
+        }
+        index = next_entry(index);
     }
 
-    if (history.historyInspectionMode == 1) {
-        inspect_shell_history();
+    // evict old entries until there's room for this one
+    while (RING_SIZE - 1 - bytes_used() < shell.length + 1) {
+        history.tail = next_entry(history.tail);
+        history.count--;
     }
 
-    // Decrement head
-    history.head = (history.head - 1) % SHELL_HISTORY_LENGTH;
-    if (history.length < SHELL_HISTORY_LENGTH) {
-        history.length++;
+    historyRing[history.head++] = shell.length;
+    for (uint8_t i = 0; i < shell.length; i++) {
+        historyRing[history.head++] = shell.buffer[i];
     }
-
-    // copy the current line into the next slot in the history queue
-    memcpy(history.line[history.head], &shell.buffer, sizeof(shell_line_t));
+    history.count++;
 }
 
 // used when we hit the up arrow
 void shell_history_show_older(void) {
     // if history is empty then what are we doing?
-    if (history.length == 0) {
+    if (history.count == 0) {
         return;
     }
 
     // since we weren't already in history mode, stash the current line
-    if (history.historyMode == 0) {
-        memcpy(&history.tempLine, &shell.buffer, sizeof(shell_line_t));
-        history.historyMode = 1;
-    }
+    enter_history_mode();
 
     // safely increment the history pointer
-    if (history.pointer < SHELL_HISTORY_LENGTH &&
-        history.pointer < history.length) {
+    if (history.pointer < history.count) {
         history.pointer++;
     }
 
-    uint8_t line = (history.head + history.pointer - 1) % SHELL_HISTORY_LENGTH;
-
-    memcpy(&shell.buffer, history.line[line], sizeof(shell_line_t));
-
-    if (history.historyInspectionMode == 1) {
-        inspect_shell_history();
-    }
-    draw_line(&shell);
-    move_cursor_to(&shell, shell.length);
+    load_entry(history.pointer);
+    redraw_line();
 }
 
 // used when we hit the down arrow
 void shell_history_show_newer(void) {
     // if history is empty then what are we doing?
-    if (history.length == 0) {
+    if (history.count == 0) {
         return;
     }
 
@@ -201,22 +316,46 @@ void shell_history_show_newer(void) {
     // once we reach the newest line, restore the stashed line buffer and quit
     if (history.pointer == 0) {
         history.historyMode = 0;
-        memcpy(&shell.buffer, &history.tempLine, sizeof(shell_line_t));
-        if (history.historyInspectionMode == 1) {
-            inspect_shell_history();
-        }
-        draw_line(&shell);
+        memcpy(&shell, &history.tempLine, sizeof(shell_line_t));
+        redraw_line();
         return;
     }
 
-    uint8_t line = (history.head + history.pointer - 1) % SHELL_HISTORY_LENGTH;
+    load_entry(history.pointer);
+    redraw_line();
+}
 
-    memcpy(&shell.buffer, history.line[line], sizeof(shell_line_t));
-    if (history.historyInspectionMode == 1) {
-        inspect_shell_history();
+/*  Prefix search, used when we hit ctrl+r
+
+    Everything left of the cursor is the search prefix. Each press finds the
+    next older entry that starts with it, and leaves the cursor at the end of
+    the prefix so pressing ctrl+r again keeps searching for the same thing.
+    An empty prefix matches everything, so it works just like the up arrow.
+*/
+void shell_history_search(void) {
+    uint8_t length = shell.cursor;
+    uint8_t found = 0;
+
+    // walk from oldest to newest, so the last match is the newest one that's
+    // older than what's currently shown
+    uint8_t index = history.tail;
+    for (uint8_t age = history.count; age > history.pointer; age--) {
+        if (entry_starts_with(index, shell.buffer, length)) {
+            found = age;
+        }
+        index = next_entry(index);
     }
+
+    if (!found) {
+        return;
+    }
+
+    enter_history_mode();
+    history.pointer = found;
+    load_entry(found);
+    shell.cursor = length;
+
     draw_line(&shell);
-    move_cursor_to(&shell, shell.length);
 }
 
-#endif
\ No newline at end of file
+#endif
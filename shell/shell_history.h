@@ -23,4 +23,7 @@ extern void shell_history_show_older(void);
 // step to the next newest history, eventually returning to the current line
 extern void shell_history_show_newer(void);
 
+// show the next older entry that starts with the text left of the cursor
+extern void shell_history_search(void);
+
 #endif
\ No newline at end of file
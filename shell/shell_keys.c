@@ -32,12 +32,6 @@ typedef struct {
     uint8_t length;
 } sequence_t;
 
-sequence_t new_sequence(void) {
-    sequence_t sequence;
-    memset(&sequence, 0, sizeof(sequence));
-    return sequence;
-}
-
 void print_sequence(sequence_t sequence) {
     sh_print("{");
     for (uint8_t i = 0; i < sequence.length; i++) {
@@ -50,287 +44,267 @@ void print_sequence(sequence_t sequence) {
 /* -------------------------------------------------------------------------- */
 
 typedef enum {
-    KEY_UP = 'A',
-    KEY_DOWN = 'B',
-    KEY_RIGHT = 'C',
-    KEY_LEFT = 'D',
-    KEY_HOME = 'H',
-    KEY_HOME2 = '1',
-    KEY_END = 'F',
-    KEY_END2 = '4',
-    KEY_DEL = '3',
-    KEY_INS = '2',
-    KEY_PGUP = '5',
-    KEY_PGDN = '6',
-    KEY_F1 = 'P',
-    KEY_F2 = 'Q',
-    KEY_F3 = 'R',
-    KEY_F4 = 'S',
-    KEY_F5 = '6',
-    KEY_F5_ALT = '5',
-    KEY_F6 = '7',
-    KEY_F7 = '8',
-    KEY_F8 = '9',
-    KEY_F9 = '0',
-    KEY_F10 = '1',
-    KEY_F11 = '3',
-    KEY_F12 = '4',
-} sequenceIdentifiers;
-
-/*  decode_escape_sequence()
-
-    Escape sequences can be uniquely identified by knowing the length of the
-    sequence and one or two characters from the sequence. Escape sequences can
-    be very different when using different terminal emulators. This decoder was
-    built with a mix of VT102 and xterm, but there's no guarantees that escape
-    sequences will be identical with other machines or configurations.
-
-    Example sequences:
-    up arrow: (ESC, 65)
-    pageup: (ESC, 53, ~)
+    KEY_ETX = 3,
+    KEY_CTRL_D = 4,
+    KEY_CTRL_E = 5,
+    KEY_BS = 8,
+    KEY_BS2 = 127,
+    KEY_TAB = 9,
+    KEY_LF = 10,
+    KEY_CR = 13,
+    KEY_CTRL_R = 18,
+    KEY_CTRL_U = 21,
+    KEY_CTRL_Y = 25,
+    KEY_ESC = 27,
+    KEY_CTRL_Z = 26,
+    KEY_CTRL_BS = 31,
+} controlCharacters;
+
+/* -------------------------------------------------------------------------- */
+/*  Escape sequence tables
+
+    Escape sequences can be very different when using different terminal
+    emulators. These tables were built with a mix of VT102 and xterm, but
+    there's no guarantees that escape sequences will be identical with other
+    machines or configurations.
+
+    There are two shapes of sequence we care about:
+
+    1)  Sequences identified by their final character:
+            up arrow:           ESC [ A
+            F1:                 ESC O P
+            ctrl + up arrow:    ESC [ 1 ; 5 A
+
+    2)  Sequences ending in '~', identified by their first number:
+            pageup:             ESC [ 5 ~
+            F5:                 ESC [ 1 5 ~
+            ctrl + delete:      ESC [ 3 ; 5 ~
+
+    If a sequence has a second number, that's the modifier. The xterm modifier
+    codes happen to line up with key_modifiers_t, so no translation is needed.
+*/
+
+typedef struct {
+    char character;
+    uint8_t key;
+} final_char_entry_t;
+
+static const final_char_entry_t finalCharTable[] = {
+    {'A', UP},    //
+    {'B', DOWN},  //
+    {'C', RIGHT}, //
+    {'D', LEFT},  //
+    {'H', HOME},  //
+    {'F', END},   //
+    {'P', F1},    //
+    {'Q', F2},    //
+    {'R', F3},    //
+    {'S', F4},    //
+};
+
+typedef struct {
+    uint8_t number;
+    uint8_t key;
+} tilde_entry_t;
+
+static const tilde_entry_t tildeTable[] = {
+    {1, HOME},     //
+    {2, INSERT},   //
+    {3, DELETE},   //
+    {4, END},      //
+    {5, PAGEUP},   //
+    {6, PAGEDOWN}, //
+    {7, HOME},     //
+    {8, END},      //
+    {11, F1},      //
+    {12, F2},      //
+    {13, F3},      //
+    {14, F4},      //
+    {15, F5},      //
+    {16, F5},      //
+    {17, F6},      //
+    {18, F7},      //
+    {19, F8},      //
+    {20, F9},      //
+    {21, F10},     //
+    {23, F11},     //
+    {24, F12},     //
+};
+
+#define TABLE_LENGTH(table) (sizeof(table) / sizeof(table[0]))
+
+/* -------------------------------------------------------------------------- */
+/*  Escape sequence decoder
+
+    The decoder used to wait for the rest of the sequence by calling getch()
+    in a loop for up to 5mS after every ESC. That froze the whole superloop,
+    and anything else that arrived during that window was eaten.
+
+    Now shell_update() passes every character it gets through
+    escape_sequence_update(), one at a time, and the decoder just remembers
+    where it is in the sequence. When a sequence is complete, the decoded key
+    is stashed, and escape_sequence_update() hands back a single ESC. Whoever
+    gets that ESC calls identify_key() like they always have, and gets the
+    stashed key back. That means shell callbacks didn't need to change at all.
+
+    A lone ESC keypress looks exactly like the start of a sequence, so if
+    nothing follows it within ESCAPE_SEQUENCE_TIMEOUT mS, it's reported as the
+    ESCAPE key. If something other than '[' or 'O' follows it, that's also an
+    ESCAPE key, but the character after it is a real keypress. It gets held
+    onto, and shell_update() collects it with escape_sequence_leftover() after
+    it's done with the ESC.
 */
-static key_t decode_escape_sequence(sequence_t *sequence) {
+
+typedef enum {
+    dIdle,   // not in a sequence
+    dEscape, // got ESC, waiting to see what comes next
+    dCSI,    // got ESC [
+    dSS3,    // got ESC O
+} decoder_state_t;
+
+#define MAX_SEQUENCE_PARAMS 2
+
+static struct {
+    decoder_state_t state;
+    sequence_t sequence;
+    uint8_t params[MAX_SEQUENCE_PARAMS];
+    uint8_t numParams;
+    system_time_t startTime;
+    key_t key;
+    char leftover;
+} decoder;
+
+static key_t lookup_final_char(char character) {
     key_t newKey = {UNKNOWN, NONE};
 
-    switch (sequence->length) {
-    case 0:
-        newKey.key = ESCAPE;
-        return newKey;
-    case 2:
-        switch (sequence->buffer[1]) {
-        default:
-            return newKey;
-        case KEY_UP:
-            newKey.key = UP;
-            return newKey;
-        case KEY_DOWN:
-            newKey.key = DOWN;
-            return newKey;
-        case KEY_RIGHT:
-            newKey.key = RIGHT;
-            return newKey;
-        case KEY_LEFT:
-            newKey.key = LEFT;
-            return newKey;
-        case KEY_HOME:
-            newKey.key = HOME;
-            return newKey;
-        case KEY_END:
-            newKey.key = END;
-            return newKey;
-        case KEY_F1:
-            newKey.key = F1;
-            return newKey;
-        case KEY_F2:
-            newKey.key = F2;
-            return newKey;
-        case KEY_F3:
-            newKey.key = F3;
-            return newKey;
-        case KEY_F4:
-            newKey.key = F4;
-            return newKey;
+    for (uint8_t i = 0; i < TABLE_LENGTH(finalCharTable); i++) {
+        if (finalCharTable[i].character == character) {
+            newKey.key = finalCharTable[i].key;
+            break;
         }
-    case 3:
-        if (sequence->buffer[2] == '~') {
-            switch (sequence->buffer[1]) {
-            default:
-                return newKey;
-            case KEY_HOME2:
-                newKey.key = HOME;
-                return newKey;
-            case KEY_END2:
-                newKey.key = END;
-                return newKey;
-            case KEY_PGUP:
-                newKey.key = PAGEUP;
-                return newKey;
-            case KEY_PGDN:
-                newKey.key = PAGEDOWN;
-                return newKey;
-            case KEY_DEL:
-                newKey.key = DELETE;
-                return newKey;
-            case KEY_INS:
-                newKey.key = INSERT;
-                return newKey;
-            }
+    }
+    return newKey;
+}
+
+static key_t lookup_tilde(uint8_t number) {
+    key_t newKey = {UNKNOWN, NONE};
+
+    for (uint8_t i = 0; i < TABLE_LENGTH(tildeTable); i++) {
+        if (tildeTable[i].number == number) {
+            newKey.key = tildeTable[i].key;
+            break;
         }
-        return newKey;
-    case 4:
-        if (sequence->buffer[3] == '~') {
-            switch (sequence->buffer[2]) {
-            default:
-                return newKey;
-            case KEY_F5:
-            case KEY_F5_ALT:
-                newKey.key = F5;
-                return newKey;
-            case KEY_F6:
-                newKey.key = F6;
-                return newKey;
-            case KEY_F7:
-                newKey.key = F7;
-                return newKey;
-            case KEY_F8:
-                newKey.key = F8;
-                return newKey;
-            case KEY_F9:
-                newKey.key = F9;
-                return newKey;
-            case KEY_F10:
-                newKey.key = F10;
-                return newKey;
-            case KEY_F11:
-                newKey.key = F11;
-                return newKey;
-            case KEY_F12:
-                newKey.key = F12;
-                return newKey;
-            }
+    }
+    return newKey;
+}
+
+// finish the current sequence and stash the key
+static char finish_sequence(key_t key) {
+    decoder.key = key;
+    decoder.state = dIdle;
+    return KEY_ESC;
+}
+
+static char decode_csi_character(char currentChar) {
+    // parameter bytes
+    if (currentChar >= '0' && currentChar <= '9') {
+        if (decoder.numParams == 0) {
+            decoder.numParams = 1;
         }
-        return newKey;
-    case 5:
-        switch (sequence->buffer[4]) {
-        default:
-            return newKey;
-        case KEY_F1:
-            newKey.key = F1;
-            break;
-        case KEY_F2:
-            newKey.key = F2;
-            break;
-        case KEY_F3:
-            newKey.key = F3;
-            break;
-        case KEY_F4:
-            newKey.key = F4;
-            break;
-        case KEY_UP:
-            newKey.key = UP;
-            break;
-        case KEY_DOWN:
-            newKey.key = DOWN;
-            break;
-        case KEY_RIGHT:
-            newKey.key = RIGHT;
-            break;
-        case KEY_LEFT:
-            newKey.key = LEFT;
-            break;
-        case KEY_HOME:
-            newKey.key = HOME;
-            break;
-        case KEY_END:
-            newKey.key = END;
-            break;
-        case '~':
-            if (sequence->buffer[1] == KEY_DEL) {
-                newKey.key = DELETE;
-                break;
-            }
-            if (sequence->buffer[1] == KEY_INS) {
-                newKey.key = INSERT;
-                break;
-            }
+        uint8_t *param = &decoder.params[decoder.numParams - 1];
+        *param = (*param * 10) + (currentChar - '0');
+        return 0;
+    }
+    if (currentChar == ';') {
+        if (decoder.numParams == 0) {
+            decoder.numParams = 1;
         }
-        newKey.mod = sequence->buffer[3] - '0';
-        return newKey;
-    case 6:
-        if (sequence->buffer[5] == '~') {
-            switch (sequence->buffer[2]) {
-            default:
-                return newKey;
-            case KEY_F5:
-            case KEY_F5_ALT:
-                newKey.key = F5;
-                break;
-            case KEY_F6:
-                newKey.key = F6;
-                break;
-            case KEY_F7:
-                newKey.key = F7;
-                break;
-            case KEY_F8:
-                newKey.key = F8;
-                break;
-            case KEY_F9:
-                newKey.key = F9;
-                break;
-            case KEY_F10:
-                newKey.key = F10;
-                break;
-            case KEY_F11:
-                newKey.key = F11;
-                break;
-            case KEY_F12:
-                newKey.key = F12;
-                break;
-            }
-            newKey.mod = sequence->buffer[4] - '0';
-            return newKey;
+        if (decoder.numParams < MAX_SEQUENCE_PARAMS) {
+            decoder.numParams++;
         }
-        return newKey;
-    default:
-        return newKey;
+        return 0;
     }
-}
 
-/* -------------------------------------------------------------------------- */
-/*  intercept_escape_sequence() should only be called when we're recieved an
-    ESC character and are expecting an unknown number of additional characters.
+    // anything else ends the sequence
+    key_t key;
+    if (currentChar == '~') {
+        key = lookup_tilde(decoder.params[0]);
+    } else {
+        key = lookup_final_char(currentChar);
+    }
 
-    Since we don't know how many characters are coming, we just have to call
-    getch() repeatedly. Every time we recieve a character, run the sequence
-    throught decode_escape_sequence(). If that returns a valid key, then quit
-    early. If it never matches, quit after ~5mS.
-*/
-static sequence_t intercept_escape_sequence(void) {
-    sequence_t sequence = new_sequence();
-
-    system_time_t startTime = get_current_time();
-    while (time_since(startTime) < 5) {
-        // int count = 0;
-        // while (1) {
-        // check for a new character
-        sequence.buffer[sequence.length] = getch();
-        // if valid character, move to next spot in buffer
-        if (sequence.buffer[sequence.length] != 0) {
-            sequence.length++;
-
-            key_t key = decode_escape_sequence(&sequence);
-            if (key.key != UNKNOWN) {
-                break;
+    if (key.key != UNKNOWN && decoder.numParams == 2) {
+        key.mod = decoder.params[1];
+    }
+    return finish_sequence(key);
+}
+
+char escape_sequence_update(char currentChar) {
+    key_t unknown = {UNKNOWN, NONE};
+    key_t escape = {ESCAPE, NONE};
+
+    if (currentChar == 0) {
+        // give up on a sequence that stopped halfway
+        if (decoder.state != dIdle) {
+            if (time_since(decoder.startTime) >= ESCAPE_SEQUENCE_TIMEOUT) {
+                if (decoder.state == dEscape) {
+                    return finish_sequence(escape);
+                }
+                return finish_sequence(unknown);
             }
         }
+        return 0;
+    }
+
+    if (decoder.state == dIdle) {
+        if (currentChar != KEY_ESC) {
+            return currentChar;
+        }
+
+        memset(&decoder, 0, sizeof(decoder));
+        decoder.state = dEscape;
+        decoder.startTime = get_current_time();
+        return 0;
+    }
 
-        // count++;
-        // if (count == 5000) {
-        //     printf("timeout\r\n");
-        //     break;
-        // }
+    // remember the raw sequence for the diagnostics
+    if (decoder.sequence.length < SEQUENCE_BUFFER_LENGTH) {
+        decoder.sequence.buffer[decoder.sequence.length++] = currentChar;
+    } else {
+        return finish_sequence(unknown);
     }
 
-    return sequence;
+    switch (decoder.state) {
+    case dEscape:
+        if (currentChar == '[') {
+            decoder.state = dCSI;
+            return 0;
+        }
+        if (currentChar == 'O') {
+            decoder.state = dSS3;
+            return 0;
+        }
+        // ESC followed by anything else is a plain ESC, and the other
+        // character still needs to be processed
+        decoder.sequence.length--;
+        decoder.leftover = currentChar;
+        return finish_sequence(escape);
+    case dCSI:
+        return decode_csi_character(currentChar);
+    case dSS3:
+        return finish_sequence(lookup_final_char(currentChar));
+    default:
+        return currentChar;
+    }
 }
 
-/* -------------------------------------------------------------------------- */
+char escape_sequence_leftover(void) {
+    char leftover = decoder.leftover;
+    decoder.leftover = 0;
+    return leftover;
+}
 
-typedef enum {
-    KEY_ETX = 3,
-    KEY_CTRL_D = 4,
-    KEY_CTRL_E = 5,
-    KEY_BS = 8,
-    KEY_BS2 = 127,
-    KEY_TAB = 9,
-    KEY_LF = 10,
-    KEY_CR = 13,
-    KEY_CTRL_U = 21,
-    KEY_CTRL_Y = 25,
-    KEY_ESC = 27,
-    KEY_CTRL_Z = 26,
-    KEY_CTRL_BS = 31,
-} controlCharacters;
+/* -------------------------------------------------------------------------- */
 
 /*  decode_control_character() identifies a key from a single control character.
 
@@ -353,6 +327,9 @@ static key_t decode_control_character(char currentChar) {
     case KEY_TAB:
         newKey.key = TAB;
         return newKey;
+    case KEY_CTRL_R:
+        newKey.key = SEARCH;
+        return newKey;
     }
 }
 
@@ -371,19 +348,18 @@ void toggle_key_diagnostics(void) {
 
 // returns a key object that identifies the pressed key
 key_t identify_key(char currentChar) {
-    sequence_t sequence = new_sequence();
     key_t key = {UNKNOWN, NONE};
 
     if (currentChar == KEY_ESC) {
-        sequence = intercept_escape_sequence();
-        key = decode_escape_sequence(&sequence);
+        // the escape sequence decoder already did the work
+        key = decoder.key;
     } else {
         key = decode_control_character(currentChar);
     }
 
     if (diagnosticsEnabled) {
         if (currentChar == KEY_ESC) {
-            print_sequence(sequence);
+            print_sequence(decoder.sequence);
         } else {
             printf("{%d} ", currentChar);
         }
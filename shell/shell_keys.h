@@ -32,7 +32,8 @@
     X(F9)                                                                      \
     X(F10)                                                                     \
     X(F11)                                                                     \
-    X(F12)
+    X(F12)                                                                     \
+    X(SEARCH)
 
 #define KEY_MODIFIER_LIST                                                      \
     X(NONE)                                                                    \
@@ -63,6 +64,15 @@ extern void print_key(key_t *key);
 // toggle real time key decoding diagnostics
 extern void toggle_key_diagnostics(void);
 
+// feed every received character (including 0) through the escape sequence
+// decoder, returns the character that should be processed normally, or 0
+// returns ESC when a complete escape sequence is ready for identify_key()
+extern char escape_sequence_update(char currentChar);
+
+// returns the character that cut the last escape sequence short, or 0
+// it should be fed back through escape_sequence_update() after the ESC
+extern char escape_sequence_leftover(void);
+
 // returns a key object that identifies the pressed key
 extern key_t identify_key(char currentChar);
 
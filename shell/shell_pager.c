@@ -0,0 +1,119 @@
+#include "shell_pager.h"
+#include "os/json/json_print.h"
+#include "os/json/json_step.h"
+#include "os/serial_port.h"
+#include "shell.h"
+#include "shell_command_processor.h"
+#include "shell_cursor.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+/* ************************************************************************** */
+
+static struct {
+    shell_row_t generator; // NULL while a JSON object is being paged
+    uint16_t row;          // the next row to print
+} pager;
+
+static json_step_t step;
+
+// print as much of the JSON object as there's room for
+static bool print_json(void) {
+    uint16_t space = serial_port_tx_space();
+
+    // save room for the newline at the end
+    if (space <= 2) {
+        return false;
+    }
+    if (!json_print_step(&step, space - 2)) {
+        return false;
+    }
+    println("");
+    return true;
+}
+
+// print as many rows as there's room for, returns true once they're all done
+static bool print_rows(void) {
+    if (!pager.generator) {
+        return print_json();
+    }
+
+    while (serial_port_tx_space() >= SHELL_PAGER_ROW_SIZE) {
+        if (!pager.generator(pager.row)) {
+            return true;
+        }
+        pager.row++;
+    }
+    return false;
+}
+
+/* -------------------------------------------------------------------------- */
+
+static int8_t pager_callback(char currentChar) {
+    // the shell stops us as soon as we return
+    if (currentChar == 3) {
+        return -1;
+    }
+
+    // anything else that's typed is thrown away
+    if (!print_rows()) {
+        return 0;
+    }
+
+    // leave the shell the way we found it
+    shell_register_callback(NULL);
+    draw_shell_prompt();
+    if (shell.length) {
+        draw_line(&shell);
+    }
+    return 0;
+}
+
+static void start_paging(void) {
+    shell_register_callback(pager_callback);
+    shellCallbackSettings.fullscreen = 0;
+}
+
+/* ************************************************************************** */
+
+bool shell_page(shell_row_t generator) {
+    // somebody else owns the shell, so there's no way to come back later
+    // that somebody might be another pager, so leave its state alone
+    if (shellCallback) {
+        uint16_t row = 0;
+        while (generator(row++)) {
+            // keep going
+        }
+        return false;
+    }
+
+    pager.generator = generator;
+    pager.row = 0;
+
+    // small dumps never need to wait
+    if (print_rows()) {
+        return false;
+    }
+
+    start_paging();
+    return true;
+}
+
+bool shell_page_json(const json_node_t *nodeList) {
+    // see shell_page()
+    if (shellCallback) {
+        json_print(print, nodeList);
+        println("");
+        return false;
+    }
+
+    pager.generator = NULL;
+    json_step_begin(&step, print, nodeList);
+
+    if (print_json()) {
+        return false;
+    }
+
+    start_paging();
+    return true;
+}
@@ -0,0 +1,62 @@
+#ifndef _SHELL_PAGER_H_
+#define _SHELL_PAGER_H_
+
+#include "os/json/json_node.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+/* ************************************************************************** */
+/*  Output pager
+
+    A command that dumps a big table with printf() holds the superloop hostage
+    until the very last byte fits in the TX buffer. At 115200 baud, that's long
+    enough to miss button presses and stall JUDI.
+
+    Instead, a command can hand the shell a row generator. The pager prints
+    rows only while the TX buffer has room for a whole row, and picks up where
+    it left off on the next pass through the superloop:
+
+        static bool print_thing_row(uint16_t row) {
+            if (row >= numberOfThings) {
+                return false;
+            }
+            printf("%u: %s\r\n", row, things[row].name);
+            return true;
+        }
+
+        void sh_things(int argc, char **argv) {
+            shell_page(print_thing_row); //
+        }
+
+    A generator is called with row 0, 1, 2... and prints exactly one row each
+    time, until it returns false. It can't keep any state in between calls, so
+    each row has to be printable from its number alone. A row shouldn't print
+    more than SHELL_PAGER_ROW_SIZE bytes, see shell_config.h.
+
+    While a dump is being paged, the shell ignores input and ctrl+c stops it.
+    When it's done, the prompt and whatever was being typed are put back.
+
+    A JSON object can be paged the same way, with shell_page_json(). It's
+    printed with json_print_step(), a few bytes at a time as the TX buffer
+    empties, and followed by a newline.
+
+    If another program is already running, like a script or watch, there's
+    nowhere to resume from, so everything is printed right away. The same
+    happens when the console is being captured, because the capture never
+    runs out of room.
+*/
+
+// prints one row, returns false if there is no such row
+typedef bool (*shell_row_t)(uint16_t row);
+
+/* ************************************************************************** */
+
+// print every row from 'generator', starting at row 0
+// returns true if the rest of the rows will be printed later
+extern bool shell_page(shell_row_t generator);
+
+// print 'nodeList' as JSON, the same way json_print() would
+// returns true if the rest of it will be printed later
+extern bool shell_page_json(const json_node_t *nodeList);
+
+#endif // _SHELL_PAGER_H_
@@ -0,0 +1,331 @@
+#include "shell_screen.h"
+#include "shell.h"
+#include "shell_utils.h"
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#ifdef LOGGING_ENABLED
+
+/* ************************************************************************** */
+
+#define WIDTH SHELL_SCREEN_WIDTH
+#define HEIGHT SHELL_SCREEN_HEIGHT
+
+static void print_attr(uint8_t attribute) {
+    sh_print("\033[0");
+    if (attribute & SCREEN_BOLD) {
+        sh_print(";1");
+    }
+    if (attribute & SCREEN_INVERT) {
+        sh_print(";7");
+    }
+    printf(";3%d;40m", attribute & 0x07);
+}
+
+void screen_printf(const char *format, ...) {
+    static char buffer[WIDTH + 1];
+    va_list args;
+
+    va_start(args, format);
+    vsnprintf(buffer, sizeof(buffer), format, args);
+    va_end(args);
+
+    screen_print(buffer);
+}
+
+#ifdef SHELL_SCREEN_ENABLED
+
+/* ************************************************************************** */
+
+// one bit per cell
+#define FLAG_BYTES ((WIDTH + 7) / 8)
+
+// marks a terminal cursor position or attribute that we can't be sure of
+#define UNKNOWN 0xff
+
+// the longest run of unchanged cells that's cheaper to reprint than skip
+#define SHORT_GAP_LENGTH 4
+
+typedef struct {
+    char text[WIDTH];
+    uint8_t attr[WIDTH];
+    uint8_t dirty[FLAG_BYTES]; // the cell has to be sent to the terminal
+    uint8_t drawn[FLAG_BYTES]; // the cell was drawn in the current frame
+} screen_row_t;
+
+/*  The text and attributes of each cell are what the terminal will show after
+    the next flush. A cell is only marked dirty when something different is
+    drawn into it, so drawing the same frame twice doesn't send anything.
+*/
+static struct {
+    screen_row_t row[HEIGHT];
+
+    // drawing state
+    uint8_t x;
+    uint8_t y;
+    uint8_t attribute;
+
+    // terminal state
+    uint8_t termX;
+    uint8_t termY;
+    uint8_t termAttr;
+    unsigned resetTerminal : 1;
+} screen;
+
+/* -------------------------------------------------------------------------- */
+
+#define get_flag(flags, x) (flags[(x) / 8] & (1 << ((x) % 8)))
+#define set_flag(flags, x) (flags[(x) / 8] |= (1 << ((x) % 8)))
+#define clear_flag(flags, x) (flags[(x) / 8] &= ~(1 << ((x) % 8)))
+
+static bool is_blank(screen_row_t *row, uint8_t x) {
+    return (row->text[x] == ' ') && (row->attr[x] == SCREEN_DEFAULT);
+}
+
+/* ************************************************************************** */
+
+void screen_init(void) {
+    for (uint8_t y = 0; y < HEIGHT; y++) {
+        memset(screen.row[y].text, ' ', WIDTH);
+        memset(screen.row[y].attr, SCREEN_DEFAULT, WIDTH);
+        memset(screen.row[y].dirty, 0, FLAG_BYTES);
+        memset(screen.row[y].drawn, 0, FLAG_BYTES);
+    }
+
+    screen.x = 0;
+    screen.y = 0;
+    screen.attribute = SCREEN_DEFAULT;
+
+    // the terminal gets wiped on the first flush, so blank cells are clean
+    screen.resetTerminal = true;
+}
+
+void screen_invalidate(void) {
+    for (uint8_t y = 0; y < HEIGHT; y++) {
+        screen_row_t *row = &screen.row[y];
+
+        for (uint8_t x = 0; x < WIDTH; x++) {
+            if (is_blank(row, x)) {
+                clear_flag(row->dirty, x);
+            } else {
+                set_flag(row->dirty, x);
+            }
+        }
+    }
+
+    screen.resetTerminal = true;
+}
+
+/* -------------------------------------------------------------------------- */
+
+void screen_clear(void) {
+    for (uint8_t y = 0; y < HEIGHT; y++) {
+        memset(screen.row[y].drawn, 0, FLAG_BYTES);
+    }
+
+    screen.x = 0;
+    screen.y = 0;
+    screen.attribute = SCREEN_DEFAULT;
+}
+
+void screen_move(uint8_t x, uint8_t y) {
+    screen.x = x;
+    screen.y = y;
+}
+
+void screen_set_attr(uint8_t attribute) {
+    screen.attribute = attribute; //
+}
+
+static void draw_cell(char c) {
+    if (screen.x >= WIDTH || screen.y >= HEIGHT) {
+        return;
+    }
+
+    screen_row_t *row = &screen.row[screen.y];
+    uint8_t x = screen.x++;
+
+    set_flag(row->drawn, x);
+
+    if (row->text[x] != c || row->attr[x] != screen.attribute) {
+        row->text[x] = c;
+        row->attr[x] = screen.attribute;
+        set_flag(row->dirty, x);
+    }
+}
+
+void screen_print(const char *string) {
+    while (*string) {
+        char c = *string++;
+
+        if (c == '\n') {
+            screen.x = 0;
+            screen.y++;
+        } else if (c != '\r') {
+            draw_cell(c);
+        }
+    }
+}
+
+/* ************************************************************************** */
+
+static void send_attr(uint8_t attribute) {
+    if (attribute == screen.termAttr) {
+        return;
+    }
+
+    print_attr(attribute);
+    screen.termAttr = attribute;
+}
+
+static void send_char(screen_row_t *row, uint8_t x) {
+    send_attr(row->attr[x]);
+    printf("%c", row->text[x]);
+
+    // after the last column, where the cursor ends up depends on the terminal
+    if (++screen.termX >= WIDTH) {
+        screen.termX = UNKNOWN;
+    }
+}
+
+/*  Move the terminal cursor to a cell, as cheaply as possible.
+
+    Unchanged cells are already correct on the terminal, so a short gap in the
+    same row can be skipped by just printing them again, as long as it doesn't
+    take an attribute change. The start of the next row is a plain newline.
+    Anything else uses a relative move within the row, or an absolute one.
+*/
+static void send_cursor_move(uint8_t x, uint8_t y) {
+    screen_row_t *row = &screen.row[y];
+
+    if (screen.termY == y && screen.termX != UNKNOWN) {
+        if (screen.termX == x) {
+            return;
+        }
+
+        if (screen.termX < x) {
+            uint8_t gap = x - screen.termX;
+            bool sameAttr = true;
+            for (uint8_t i = screen.termX; i < x; i++) {
+                if (row->attr[i] != screen.termAttr) {
+                    sameAttr = false;
+                    break;
+                }
+            }
+
+            if (gap <= SHORT_GAP_LENGTH && sameAttr) {
+                while (screen.termX < x) {
+                    send_char(row, screen.termX);
+                }
+            } else {
+                term_cursor_right(gap);
+            }
+        } else {
+            term_cursor_left(screen.termX - x);
+        }
+    } else if (x == 0 && screen.termY != UNKNOWN && y == screen.termY + 1) {
+        sh_print("\r\n");
+    } else {
+        term_cursor_set(x + 1, y + 1);
+    }
+
+    screen.termX = x;
+    screen.termY = y;
+}
+
+void screen_flush(void) {
+    if (screen.resetTerminal) {
+        screen.resetTerminal = false;
+        reset_text_attributes();
+        term_reset_screen();
+        screen.termAttr = SCREEN_DEFAULT;
+        screen.termX = UNKNOWN;
+        screen.termY = UNKNOWN;
+    }
+
+    for (uint8_t y = 0; y < HEIGHT; y++) {
+        screen_row_t *row = &screen.row[y];
+
+        for (uint8_t x = 0; x < WIDTH; x++) {
+            // anything that wasn't drawn this frame is blank
+            if (!get_flag(row->drawn, x) && !is_blank(row, x)) {
+                row->text[x] = ' ';
+                row->attr[x] = SCREEN_DEFAULT;
+                set_flag(row->dirty, x);
+            }
+
+            if (get_flag(row->dirty, x)) {
+                clear_flag(row->dirty, x);
+                send_cursor_move(x, y);
+                send_char(row, x);
+            }
+        }
+    }
+
+    // leave the terminal in a sane state for anybody else
+    send_attr(SCREEN_DEFAULT);
+}
+
+#else // #ifdef SHELL_SCREEN_ENABLED
+
+/* ************************************************************************** */
+/*  Without the buffer, everything goes straight to the terminal. There's
+    nothing to compare a frame against, so screen_clear() wipes the terminal
+    and the program redraws all of it.
+*/
+
+static uint8_t termAttr;
+
+void screen_init(void) {
+    termAttr = SCREEN_DEFAULT; //
+}
+
+void screen_invalidate(void) {
+    // every frame is already a full redraw
+}
+
+/* -------------------------------------------------------------------------- */
+
+void screen_clear(void) {
+    reset_text_attributes();
+    term_reset_screen();
+    termAttr = SCREEN_DEFAULT;
+}
+
+void screen_move(uint8_t x, uint8_t y) {
+    term_cursor_set(x + 1, y + 1); //
+}
+
+void screen_set_attr(uint8_t attribute) {
+    if (attribute == termAttr) {
+        return;
+    }
+
+    print_attr(attribute);
+    termAttr = attribute;
+}
+
+void screen_print(const char *string) {
+    while (*string) {
+        char c = *string++;
+
+        if (c == '\n') {
+            sh_print("\r\n");
+        } else if (c != '\r') {
+            printf("%c", c);
+        }
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+
+void screen_flush(void) {
+    screen_set_attr(SCREEN_DEFAULT); //
+}
+
+#endif // #ifdef SHELL_SCREEN_ENABLED
+
+#endif // #ifdef LOGGING_ENABLED
@@ -0,0 +1,88 @@
+#ifndef _SHELL_SCREEN_H_
+#define _SHELL_SCREEN_H_
+
+#include <stdint.h>
+
+/* ************************************************************************** */
+/*  Full screen renderer
+
+    Fullscreen shell programs, like logedit, used to redraw themselves by
+    clearing the terminal and printing every row again. That's simple, but it
+    sends kilobytes to change a single cell, and at 115200 baud you can watch
+    it happen.
+
+    Instead, a program can draw into this screen buffer, which remembers what
+    each cell of the terminal currently shows. screen_flush() compares that
+    against what was drawn and only sends the cells that actually changed,
+    with the cheapest cursor move it can find and an attribute change only
+    when the attribute actually changes.
+
+    Each frame looks like this:
+        screen_clear();         // start a new frame
+        screen_print("...");    // draw the whole screen, as if it were blank
+        screen_flush();         // send the difference
+
+    Cells that weren't drawn since screen_clear() are blanked by the flush, so
+    a program never has to erase anything itself. Redrawing an unchanged frame
+    sends nothing at all.
+
+    Drawing past the edge of the screen is clipped. The buffer costs about
+    2.25 bytes of RAM per cell, so it's only there if SHELL_SCREEN_ENABLED is
+    defined in shell_config.h, see also SHELL_SCREEN_WIDTH and
+    SHELL_SCREEN_HEIGHT. Without it, these functions print straight to the
+    terminal, and screen_clear() wipes it, so every frame is a full redraw.
+*/
+
+/* ************************************************************************** */
+// cell attributes
+
+// colors, in ANSI order
+enum {
+    SCREEN_BLACK,
+    SCREEN_RED,
+    SCREEN_GREEN,
+    SCREEN_YELLOW,
+    SCREEN_BLUE,
+    SCREEN_MAGENTA,
+    SCREEN_CYAN,
+    SCREEN_WHITE,
+};
+
+// effects, combine with a color
+#define SCREEN_BOLD 0x08
+#define SCREEN_INVERT 0x10
+
+// the same attributes as TXT_RESET
+#define SCREEN_DEFAULT SCREEN_WHITE
+
+/* ************************************************************************** */
+
+// forget everything and clear the terminal on the next flush
+extern void screen_init(void);
+
+// the terminal was changed behind our back, so resend everything next flush
+extern void screen_invalidate(void);
+
+/* -------------------------------------------------------------------------- */
+
+// start a new frame, with the drawing position at the top left corner
+extern void screen_clear(void);
+
+// move the drawing position
+extern void screen_move(uint8_t x, uint8_t y);
+
+// set the attribute used by anything drawn after this
+extern void screen_set_attr(uint8_t attribute);
+
+// draw a string, '\n' moves to the beginning of the next row
+extern void screen_print(const char *string);
+
+// draw a formatted string, clipped to the width of the screen
+extern void screen_printf(const char *format, ...);
+
+/* -------------------------------------------------------------------------- */
+
+// send everything that's changed since the last flush to the terminal
+extern void screen_flush(void);
+
+#endif // _SHELL_SCREEN_H_
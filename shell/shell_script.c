@@ -0,0 +1,156 @@
+#include "shell_script.h"
+#include "os/serial_port.h"
+#include "shell.h"
+#include "shell_command_processor.h"
+#include <ctype.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#ifdef LOGGING_ENABLED
+
+/* ************************************************************************** */
+
+SHELL_COMMAND(sh_script, "script");
+
+/* ************************************************************************** */
+
+#define KEY_ETX 3 // ctrl+c
+#define KEY_EOT 4 // ctrl+d
+
+static struct {
+    shell_line_t line;
+    char copy[SHELL_MAX_LENGTH]; // process_shell_command() chops up the line
+    uint16_t lineNumber;
+    uint16_t ok;
+    uint16_t failed;
+    unsigned tooLong : 1;
+    unsigned afterCR : 1;
+} script;
+
+/* -------------------------------------------------------------------------- */
+
+static void report_failure(const char *reason) {
+    script.failed++;
+    printf("line %u: %s: %s\r\n", script.lineNumber, reason, script.copy);
+}
+
+static void print_summary(void) {
+    printf("script: %u lines, %u ok, %u failed\r\n", script.lineNumber,
+           script.ok, script.failed);
+}
+
+// returns true if the line doesn't have anything to run
+static bool is_blank_line(shell_line_t *line) {
+    for (uint8_t i = 0; i < line->length; i++) {
+        if (line->buffer[i] == '#') {
+            return true;
+        }
+        if (line->buffer[i] != ' ') {
+            return false;
+        }
+    }
+    return true;
+}
+
+static int8_t script_callback(char currentChar);
+
+static void run_line(void) {
+    script.lineNumber++;
+    shell_add_terminator_to_line(script.line);
+    strcpy(script.copy, script.line.buffer);
+
+    if (script.tooLong) {
+        report_failure("line too long");
+        return;
+    }
+    if (is_blank_line(&script.line)) {
+        return;
+    }
+
+    if (process_shell_command(&script.line) == -1) {
+        report_failure("command not found");
+        return;
+    }
+
+    // the command tried to start an interactive program, so take back over
+    if (shellCallback != script_callback) {
+        shell_register_callback(script_callback);
+        shellCallbackSettings.fullscreen = 0;
+        report_failure("interactive command");
+        return;
+    }
+
+    script.ok++;
+}
+
+// hold off the sender from the moment a line starts until it's done
+static void execute_line(void) {
+    putch(XOFF);
+    run_line();
+    putch(XON);
+}
+
+static int8_t script_callback(char currentChar) {
+    if (currentChar == 0) {
+        return 0;
+    }
+
+    bool afterCR = script.afterCR;
+    script.afterCR = (currentChar == '\r');
+
+    switch (currentChar) {
+    case KEY_ETX:
+    case KEY_EOT:
+        // finish a last line that didn't have a newline
+        if (script.line.length) {
+            execute_line();
+        }
+        print_summary();
+        return -1;
+    case '\r':
+    case '\n':
+        // ignore the second half of a CRLF
+        if (afterCR && currentChar == '\n') {
+            return 0;
+        }
+
+        execute_line();
+
+        shell_reset_line(script.line);
+        script.tooLong = false;
+        return 0;
+    }
+
+    if (currentChar == '\t') {
+        currentChar = ' ';
+    }
+
+    // stray control characters, like a terminal's own XON/XOFF or an ESC,
+    // would end up in the command
+    if (!isprint(currentChar)) {
+        return 0;
+    }
+
+    if (script.line.length < SHELL_MAX_LENGTH - 1) {
+        script.line.buffer[script.line.length++] = currentChar;
+    } else {
+        script.tooLong = true;
+    }
+    return 0;
+}
+
+/* -------------------------------------------------------------------------- */
+
+void sh_script(int argc, char **argv) {
+    memset(&script, 0, sizeof(script));
+
+    println("script mode, press ctrl+d when done");
+    putch(XON);
+
+    shell_register_callback(script_callback);
+    shellCallbackSettings.fullscreen = 0;
+}
+
+#endif // #ifdef LOGGING_ENABLED
@@ -0,0 +1,41 @@
+#ifndef _SHELL_SCRIPT_H_
+#define _SHELL_SCRIPT_H_
+
+/* ************************************************************************** */
+/*  Script mode
+
+    Provisioning a board means pasting dozens of commands into the terminal.
+    The normal line editor echoes every character, redraws, and prints a
+    prompt after every command, and without any flow control, characters get
+    dropped whenever a command takes a while to run.
+
+    The "script" shell command switches to a mode meant for pasted input:
+        - nothing is echoed, and no prompts are printed
+        - each complete line is executed as soon as it arrives
+        - XOFF is sent as soon as a line starts executing, and XON once it's
+          done, so a terminal with software flow control will pace itself
+        - blank lines and lines starting with '#' are ignored
+        - tabs become spaces, and other non-printing characters are dropped
+
+    Commands still print their own output. Any line that fails is reported
+    with its line number, and a summary is printed at the end.
+
+    Press ctrl+d (or ctrl+c) when the script is done:
+        $ script
+        <paste>
+        ^D
+        script: 42 lines, 40 ok, 2 failed
+
+    Interactive programs, like logedit, can't be used from a script. If a line
+    starts one, it's stopped immediately and the line is counted as failed.
+*/
+
+// software flow control characters
+#define XON 0x11
+#define XOFF 0x13
+
+/* ************************************************************************** */
+
+extern void sh_script(int argc, char **argv);
+
+#endif // _SHELL_SCRIPT_H_
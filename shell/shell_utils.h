@@ -24,6 +24,9 @@
 // clear the line to the right of the cursor
 #define term_clear_to_right() sh_print("\033[0K")
 
+// clear from the cursor to the end of the screen
+#define term_clear_below() sh_print("\033[0J")
+
 /* -------------------------------------------------------------------------- */
 
 #define term_hide_cursor() sh_print("\033[?25l")
@@ -0,0 +1,176 @@
+#include "shell_watch.h"
+#include "os/serial_port.h"
+#include "os/system_time.h"
+#include "os/tasks.h"
+#include "shell.h"
+#include "shell_command_processor.h"
+#include "shell_keys.h"
+#include "shell_utils.h"
+#include <ctype.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef LOGGING_ENABLED
+
+/* ************************************************************************** */
+
+SHELL_COMMAND(sh_every, "every");
+SHELL_COMMAND(sh_watch, "watch");
+
+/* ************************************************************************** */
+
+static struct {
+    char command[SHELL_MAX_LENGTH]; // the command line to run, with arguments
+    shell_line_t line;              // scratch copy, since it gets chopped up
+    system_time_t interval;
+    uint16_t runs;
+    uint8_t taskID;
+    unsigned inPlace : 1;
+} watch;
+
+/* -------------------------------------------------------------------------- */
+
+// run the command once, returns the result of process_shell_command()
+static int8_t run_command(void) {
+    shell_reset_line(watch.line);
+    strcpy(watch.line.buffer, watch.command);
+    watch.line.length = strlen(watch.command);
+
+    if (watch.inPlace) {
+        // header on the first line, then wipe out the previous output
+        term_cursor_set(0, 0);
+        printf("watch %lu mS: %s", watch.interval, watch.command);
+        term_clear_to_right();
+        sh_println("");
+        term_clear_below();
+    }
+
+    system_time_t start = get_current_time();
+    int8_t result = process_shell_command(&watch.line);
+    system_time_t elapsed = time_since(start);
+
+    watch.runs++;
+    if (watch.inPlace) {
+        printf("\r\nrun %u took %lu mS\r\n", watch.runs, elapsed);
+    } else {
+        printf("[%lu] %s took %lu mS\r\n", get_current_time(), watch.command,
+               elapsed);
+    }
+
+    return result;
+}
+
+static void watch_task(void) {
+    run_command(); //
+}
+
+static void stop_watching(void) {
+    unregister_task(watch.taskID);
+    watch.taskID = NO_TASK;
+}
+
+/* -------------------------------------------------------------------------- */
+
+static int8_t watch_callback(char currentChar) {
+    switch (currentChar) {
+    case 0:
+        break;
+    case 3: // ctrl+c, the shell will terminate us as soon as we return
+    case 'q':
+    case 'Q':
+        stop_watching();
+        return -1;
+    default:
+        if (iscntrl(currentChar)) {
+            key_t key = identify_key(currentChar);
+            if (key.key == ESCAPE) {
+                stop_watching();
+                return -1;
+            }
+        }
+        break;
+    }
+
+    check_task(watch.taskID);
+
+    // the command started an interactive program, which replaced us
+    if (shellCallback != watch_callback) {
+        stop_watching();
+    }
+
+    return 0;
+}
+
+/* -------------------------------------------------------------------------- */
+
+static void start_watching(int argc, char **argv, bool inPlace) {
+    // somebody else owns the shell, and we'd steal it from them
+    if (shellCallback) {
+        printf("%s: the shell is busy\r\n", argv[0]);
+        return;
+    }
+
+    if (argc < 3) {
+        printf("usage: %s <interval in mS> <command> [args...]\r\n", argv[0]);
+        return;
+    }
+
+    system_time_t interval = strtoul(argv[1], NULL, 10);
+    if (interval == 0) {
+        printf("%s: invalid interval: %s\r\n", argv[0], argv[1]);
+        return;
+    }
+
+    // put the command line back together
+    watch.command[0] = '\0';
+    for (uint8_t i = 2; i < argc; i++) {
+        if (i > 2) {
+            strcat(watch.command, " ");
+        }
+        strcat(watch.command, argv[i]);
+    }
+
+    watch.interval = interval;
+    watch.runs = 0;
+    watch.inPlace = inPlace;
+
+    if (inPlace) {
+        term_reset_screen();
+    }
+
+    // take over the shell first, so a paged command prints everything at once
+    shell_register_callback(watch_callback);
+    shellCallbackSettings.fullscreen = inPlace;
+
+    // run it once right away, which also makes sure the command exists
+    if (run_command() == -1) {
+        shell_register_callback(NULL);
+        printf("%s: command not found\r\n", argv[2]);
+        return;
+    }
+    if (shellCallback != watch_callback) {
+        shell_register_callback(NULL);
+        printf("%s: can't repeat an interactive command\r\n", argv[0]);
+        return;
+    }
+
+    watch.taskID = register_task(watch_task, interval);
+    if (watch.taskID == NO_TASK) {
+        shell_register_callback(NULL);
+        printf("%s: no free tasks\r\n", argv[0]);
+        return;
+    }
+}
+
+void sh_every(int argc, char **argv) {
+    start_watching(argc, argv, false); //
+}
+
+void sh_watch(int argc, char **argv) {
+    start_watching(argc, argv, true); //
+}
+
+#endif // #ifdef LOGGING_ENABLED
@@ -0,0 +1,29 @@
+#ifndef _SHELL_WATCH_H_
+#define _SHELL_WATCH_H_
+
+/* ************************************************************************** */
+/*  Periodic commands
+
+    Monitoring a value used to mean typing the same command over and over, or
+    writing a custom shell callback like clockmon. These two commands run any
+    other shell command on a fixed interval instead:
+
+        $ every 1000 uptime         run 'uptime' every second, scrolling
+        $ watch 250 records         run 'records' 4 times a second, in place
+
+    'every' lets the output scroll, and adds a line after each run with the
+    time and how long the command took. 'watch' clears the screen and redraws
+    the output in the same spot every time, with a header at the top.
+
+    The command is scheduled with a task from tasks.c, so nothing blocks in
+    between runs. Press 'q', ESC, or ctrl+c to stop.
+
+    Interactive programs, like logedit, can't be watched.
+*/
+
+/* ************************************************************************** */
+
+extern void sh_every(int argc, char **argv);
+extern void sh_watch(int argc, char **argv);
+
+#endif // _SHELL_WATCH_H_
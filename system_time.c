@@ -5,9 +5,10 @@
 
 /* ************************************************************************** */
 
-// forward declaration
-extern void sh_clockmon(int argc, char **argv);
-extern void sh_uptime(int argc, char **argv);
+#ifdef DEVELOPMENT
+SHELL_COMMAND(sh_clockmon, "clockmon");
+SHELL_COMMAND(sh_uptime, "uptime");
+#endif
 
 void system_time_init(void) {
     nco1_set_pulse_frequency_mode(NCO_MODE_PULSE_FREQUENCY);
@@ -31,11 +32,6 @@ void system_time_init(void) {
     smt_start();
 
     smt_interrupt_enable();
-
-#ifdef DEVELOPMENT
-    shell_register_command(sh_clockmon, "clockmon");
-    shell_register_command(sh_uptime, "uptime");
-#endif
 }
 
 /* -------------------------------------------------------------------------- */
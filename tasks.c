@@ -1,11 +1,12 @@
 #include "tasks.h"
+#include <stddef.h>
 
 /* ************************************************************************** */
 
 typedef struct task {
     system_time_t lastAttempt;
     system_time_t cooldown;
-    void (*task_func)(void);
+    void (*task_func)(void); // NULL means the slot is free
 } task_t;
 
 #define MAX_NUM_OF_TASKS 10
@@ -20,27 +21,57 @@ static task_registry_t registry;
 /* ************************************************************************** */
 
 void task_manager_init(void) {
-    //
+    for (uint8_t i = 0; i < MAX_NUM_OF_TASKS; i++) {
+        registry.taskList[i].task_func = NULL;
+    }
     registry.numOfTasks = 0;
 }
 
 uint8_t register_task(void (*task_func)(void), system_time_t cooldown) {
-    //
-    registry.taskList[registry.numOfTasks].task_func = task_func;
-    registry.taskList[registry.numOfTasks].cooldown = cooldown;
-    
-    return registry.numOfTasks++;
+    // reuse a slot that was freed by unregister_task(), if there is one
+    uint8_t taskID = 0;
+    while (taskID < registry.numOfTasks &&
+           registry.taskList[taskID].task_func != NULL) {
+        taskID++;
+    }
+
+    if (taskID == MAX_NUM_OF_TASKS) {
+        return NO_TASK;
+    }
+    if (taskID == registry.numOfTasks) {
+        registry.numOfTasks++;
+    }
+
+    registry.taskList[taskID].task_func = task_func;
+    registry.taskList[taskID].cooldown = cooldown;
+    registry.taskList[taskID].lastAttempt = get_current_time();
+
+    return taskID;
+}
+
+void unregister_task(uint8_t taskID) {
+    if (taskID < registry.numOfTasks) {
+        registry.taskList[taskID].task_func = NULL;
+    }
 }
 
 bool check_task(uint8_t taskID) {
-    task_t task = registry.taskList[taskID];
+    if (taskID >= registry.numOfTasks) {
+        return false;
+    }
 
-    if (time_since(task.lastAttempt) < task.cooldown) {
+    // this has to be a pointer, a copy would never remember lastAttempt
+    task_t *task = &registry.taskList[taskID];
+
+    if (task->task_func == NULL) {
+        return false;
+    }
+    if (time_since(task->lastAttempt) < task->cooldown) {
         return false;
     }
-    task.lastAttempt = get_current_time();
+    task->lastAttempt = get_current_time();
 
-    task.task_func();
+    task->task_func();
 
     return true;
 }
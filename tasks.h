@@ -6,8 +6,36 @@
 #include <stdint.h>
 
 /* ************************************************************************** */
+/*  Cooperative tasks
 
+    A task is a function that should run no more often than once every
+    'cooldown' milliseconds. Nothing runs tasks automatically; whoever owns a
+    task calls check_task() from their own update function, and the task only
+    runs if its cooldown has expired. check_task() never blocks.
+
+    Example:
+        uint8_t blinkTask = register_task(blink_led, 500);
+        ...
+        check_task(blinkTask); // in the superloop, or a shell callback
+*/
+
+// returned by register_task() when every slot is in use
+#define NO_TASK 0xff
+
+/* ************************************************************************** */
+
+// setup
+extern void task_manager_init(void);
+
+// returns the new task's ID, or NO_TASK. The first run is one cooldown from now.
+extern uint8_t register_task(void (*task_func)(void), system_time_t cooldown);
+
+// stop a task and free its slot for somebody else
+extern void unregister_task(uint8_t taskID);
+
+// run the task if its cooldown has expired, returns true if it ran
+extern bool check_task(uint8_t taskID);
 
 /* ************************************************************************** */
 
-#endif // _TASKS_H_
\ No newline at end of file
+#endif // _TASKS_H_